@@ -0,0 +1,210 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: bench.cpp
+ */
+
+// Runs the workloads in bench/workloads on both engines and prints one JSON
+// object per line with the wall time, peak resident memory and allocations
+// of each run, so that results of two versions can be compared line by line.
+// Every run happens in a child process of its own, so that one workload
+// cannot change the memory or allocator state another starts with. Stream
+// workloads run their record function on every line of a generated input,
+// as --each does, and also report lines per second.
+//
+// Usage: monet_benchmarks workload-dir [runs]
+// The fastest of the runs is reported, 3 by default.
+
+#include "../src/Interpreter.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+std::atomic<size_t> allocations{0};
+
+const char *const WORKLOADS[] = {"fib",      "memofib",      "lists",
+                                 "printing", "higher_order", "arith",
+                                 "each"};
+// workloads that define record and run on STREAM_LINES lines of input
+const char *const STREAMS[] = {"each"};
+const size_t STREAM_LINES = 500000;
+} // namespace
+
+void *operator new(std::size_t size) {
+  allocations++;
+  void *memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+struct Result {
+  double ms = 0;
+  size_t allocations = 0;
+  long peakKb = 0;
+  std::string error;
+};
+
+bool isStream(const std::string &workload) {
+  for (const char *stream : STREAMS) {
+    if (workload == stream) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * measure- runs a program in the calling process, output goes nowhere
+ * @param path the program
+ * @param engine the engine its functions run on
+ * @param lines the lines of input record runs on, 0 to only run the program
+ * @return the line the child reports, "ms allocations" or "error text"
+ */
+std::string measure(const std::string &path, Engine engine, size_t lines) {
+  const int null = open("/dev/null", O_WRONLY);
+  dup2(null, STDOUT_FILENO);
+  close(null);
+  std::string text;
+  for (size_t x = 0; x < lines; ++x) {
+    text += std::to_string(x * 7919 % 100003) + "\n";
+  }
+  std::istringstream input(text);
+  Options options;
+  options.engine = engine;
+  options.input = &input;
+  const size_t before = allocations;
+  const auto start = std::chrono::steady_clock::now();
+  try {
+    Interpreter interpreter(options);
+    interpreter.runFile(path);
+    if (lines != 0) {
+      interpreter.each("record");
+    }
+  } catch (Quit &) {
+  } catch (Exception &e) {
+    return "error " + e.what();
+  }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return std::to_string(elapsed.count()) + " " +
+         std::to_string(allocations - before);
+}
+
+/**
+ * run- runs a program in a child process
+ * @param path the program
+ * @param engine the engine its functions run on
+ * @param lines the lines of input of a stream workload, else 0
+ * @return what the run took
+ */
+Result run(const std::string &path, Engine engine, size_t lines) {
+  Result result;
+  int channel[2];
+  if (pipe(channel) != 0) {
+    result.error = "unable to open a pipe";
+    return result;
+  }
+  const pid_t child = fork();
+  if (child == 0) {
+    close(channel[0]);
+    const std::string line = measure(path, engine, lines);
+    ssize_t written = write(channel[1], line.data(), line.size());
+    _exit(written == static_cast<ssize_t>(line.size()) ? 0 : 1);
+  }
+  close(channel[1]);
+  std::string report;
+  char buffer[256];
+  ssize_t count;
+  while ((count = read(channel[0], buffer, sizeof(buffer))) > 0) {
+    report.append(buffer, count);
+  }
+  close(channel[0]);
+  int status = 0;
+  struct rusage usage = {};
+  if (child < 0 || wait4(child, &status, 0, &usage) != child ||
+      !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    result.error = "the run crashed";
+    return result;
+  }
+  if (report.rfind("error ", 0) == 0) {
+    result.error = report.substr(6);
+    return result;
+  }
+  std::istringstream(report) >> result.ms >> result.allocations;
+  // kilobytes on Linux
+  result.peakKb = usage.ru_maxrss;
+  return result;
+}
+
+std::string quote(const std::string &text) {
+  std::string out = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c < 0x20 ? ' ' : c;
+  }
+  return out + "\"";
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3 || (argc == 3 && std::atoi(argv[2]) < 1)) {
+    std::cerr << "Usage: monet_benchmarks workload-dir [runs]" << std::endl;
+    return 1;
+  }
+  const std::string dir = argv[1];
+  const int runs = argc == 3 ? std::atoi(argv[2]) : 3;
+  bool passed = true;
+  for (const char *workload : WORKLOADS) {
+    const size_t lines = isStream(workload) ? STREAM_LINES : 0;
+    for (Engine engine : {Engine::VM, Engine::Tree}) {
+      Result best;
+      for (int x = 0; x < runs && best.error.empty(); ++x) {
+        Result result = run(dir + "/" + workload + ".mo", engine, lines);
+        if (x == 0 || !result.error.empty() || result.ms < best.ms) {
+          best.ms = result.ms;
+          best.allocations = result.allocations;
+          best.error = result.error;
+        }
+        best.peakKb = std::max(best.peakKb, result.peakKb);
+      }
+      std::cout << "{\"workload\":" << quote(workload) << ",\"engine\":"
+                << quote(engine == Engine::VM ? "vm" : "tree");
+      if (best.error.empty()) {
+        std::cout << ",\"ms\":" << best.ms
+                  << ",\"peak_rss_kb\":" << best.peakKb
+                  << ",\"allocations\":" << best.allocations;
+        if (lines != 0) {
+          std::cout << ",\"lines_per_second\":"
+                    << static_cast<uint64_t>(lines * 1000.0 / best.ms);
+        }
+        std::cout << "}";
+      } else {
+        std::cout << ",\"error\":" << quote(best.error) << "}";
+        passed = false;
+      }
+      std::cout << std::endl;
+    }
+  }
+  return passed ? 0 : 1;
+}
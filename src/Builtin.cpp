@@ -0,0 +1,125 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Builtin.cpp
+ */
+
+#include "Builtin.h"
+
+namespace {
+struct Entry {
+  std::string_view name;
+  Builtin builtin;
+};
+
+constexpr Entry BUILTINS[] = {
+    {"print", Builtin::Print},
+    {"println", Builtin::Println},
+    {"quit", Builtin::Quit},
+    {"boolean", Builtin::Boolean},
+    {"num", Builtin::Num},
+    {"string", Builtin::String},
+    {"read", Builtin::Read},
+    {"add", Builtin::Add},
+    {"sub", Builtin::Sub},
+    {"mul", Builtin::Mul},
+    {"div", Builtin::Div},
+    {"not", Builtin::Not},
+    {"and", Builtin::And},
+    {"or", Builtin::Or},
+    {"nand", Builtin::Nand},
+    {"nor", Builtin::Nor},
+    {"xor", Builtin::Xor},
+    {"xnor", Builtin::Xnor},
+    {"if", Builtin::If},
+    {"eq", Builtin::Eq},
+    {"ne", Builtin::Ne},
+    {"gt", Builtin::Gt},
+    {"lt", Builtin::Lt},
+    {"ge", Builtin::Ge},
+    {"le", Builtin::Le},
+    {"<=>", Builtin::Compare},
+    {"define", Builtin::Define},
+    {"return", Builtin::Return},
+    {"end", Builtin::End},
+    {"subroutine", Builtin::Subroutine},
+    {"defmem", Builtin::Defmem},
+    {"load", Builtin::Load},
+    {"list", Builtin::List},
+    {"cons", Builtin::Cons},
+    {"head", Builtin::Head},
+    {"tail", Builtin::Tail},
+    {"null", Builtin::Null},
+    {"memstats", Builtin::Memstats},
+    {"map", Builtin::Map},
+    {"filter", Builtin::Filter},
+    {"reduce", Builtin::Reduce},
+    {"foldr", Builtin::Foldr},
+    {"pmap", Builtin::Pmap},
+    {"preduce", Builtin::Preduce},
+    {"flush", Builtin::Flush}};
+
+constexpr size_t COUNT = sizeof(BUILTINS) / sizeof(BUILTINS[0]);
+constexpr size_t TABLE_SIZE = 128;
+constexpr uint8_t EMPTY = 0xff;
+
+// Every builtin is at least two characters long. The multipliers were
+// searched for so that no two builtins share a slot.
+constexpr size_t slot(std::string_view word) {
+  return (word.length() + 9 * static_cast<unsigned char>(word[0]) +
+          15 * static_cast<unsigned char>(word[1]) +
+          20 * static_cast<unsigned char>(word.back())) %
+         TABLE_SIZE;
+}
+
+struct Table {
+  // index into BUILTINS for every slot
+  uint8_t slots[TABLE_SIZE];
+  bool perfect;
+};
+
+constexpr Table build() {
+  Table table{};
+  table.perfect = true;
+  for (size_t x = 0; x < TABLE_SIZE; ++x) {
+    table.slots[x] = EMPTY;
+  }
+  for (size_t x = 0; x < COUNT; ++x) {
+    const size_t s = slot(BUILTINS[x].name);
+    if (table.slots[s] != EMPTY ||
+        static_cast<size_t>(BUILTINS[x].builtin) != x + 1) {
+      table.perfect = false;
+    }
+    table.slots[s] = static_cast<uint8_t>(x);
+  }
+  return table;
+}
+
+constexpr Table TABLE = build();
+static_assert(TABLE.perfect, "Builtins collide in the hash table or are out "
+                             "of order, change the multipliers in slot()");
+} // namespace
+
+/**
+ * find
+ * @param word a word of a program
+ * @return the builtin the word names, None if it is not reserved
+ */
+Builtin Builtins::find(std::string_view word) {
+  if (word.length() < 2) {
+    return Builtin::None;
+  }
+  const uint8_t index = TABLE.slots[slot(word)];
+  if (index == EMPTY || BUILTINS[index].name != word) {
+    return Builtin::None;
+  }
+  return BUILTINS[index].builtin;
+}
+
+std::string_view Builtins::name(Builtin builtin) {
+  return builtin == Builtin::None
+             ? std::string_view()
+             : BUILTINS[static_cast<size_t>(builtin) - 1].name;
+}
@@ -0,0 +1,76 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Builtin.h
+ */
+
+#ifndef MONET_BUILTIN_H
+#define MONET_BUILTIN_H
+
+#include <cstdint>
+#include <string_view>
+
+// The order must match the table in Builtin.cpp
+enum class Builtin : uint8_t {
+  None,
+  Print,
+  Println,
+  Quit,
+  Boolean,
+  Num,
+  String,
+  Read,
+  Add,
+  Sub,
+  Mul,
+  Div,
+  Not,
+  And,
+  Or,
+  Nand,
+  Nor,
+  Xor,
+  Xnor,
+  If,
+  Eq,
+  Ne,
+  Gt,
+  Lt,
+  Ge,
+  Le,
+  Compare,
+  Define,
+  Return,
+  End,
+  Subroutine,
+  Defmem,
+  Load,
+  List,
+  Cons,
+  Head,
+  Tail,
+  Null,
+  Memstats,
+  Map,
+  Filter,
+  Reduce,
+  Foldr,
+  Pmap,
+  Preduce,
+  Flush
+};
+
+/**
+ * Builtins- the reserved words of the language
+ * Words are resolved to their builtin with a perfect hash built at compile
+ * time, so a lookup is one hash and at most one string compare.
+ */
+class Builtins {
+public:
+  static Builtin find(std::string_view word);
+  static std::string_view name(Builtin builtin);
+};
+
+#endif // MONET_BUILTIN_H
@@ -0,0 +1,54 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Bytecode.h
+ */
+
+#ifndef MONET_BYTECODE_H
+#define MONET_BYTECODE_H
+
+#include "Node.h"
+#include "Value.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The order of the opcodes must match the dispatch table in VM::run
+enum class Op : uint8_t {
+  Constant,    // push constants[a]
+  Load,        // push the value of the word with symbol a and slot b
+  CallBuiltIn, // call the builtin numbered a with the top b values
+  Call,        // call the function constants[a] with the top b values
+  TailCall,    // as Call, when its value is returned straight away
+  Declare,     // declare the symbol b as a constants[a] from the top value
+  Jump,        // continue at instruction a
+  JumpIfFalse, // pop a boolean, continue at instruction a if it is false
+  Pop,         // discard the top value
+  Eval,        // push the value of nodes[a] evaluated by the tree walker
+  Return       // return the top value
+};
+
+struct Instruction {
+  Op op;
+  uint32_t a;
+  uint32_t b;
+};
+
+/**
+ * Chunk- the bytecode of one function body
+ */
+struct Chunk {
+  std::vector<Instruction> code;
+  std::vector<Value> constants;
+  // statements the compiler leaves to the tree walker
+  std::vector<Node> nodes;
+  // the function each constant names, filled in by the first call that finds
+  // it. Definitions are never replaced, so it stays right for every run
+  mutable std::unique_ptr<std::atomic<const Function *>[]> callees;
+};
+
+#endif // MONET_BYTECODE_H
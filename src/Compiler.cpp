@@ -0,0 +1,201 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Compiler.cpp
+ */
+
+#include "Compiler.h"
+
+Compiler::Compiler(const Memory &memory) : memory(memory) {}
+
+/**
+ * compile
+ * @param function a parsed function
+ * @return the bytecode for the body of the function
+ */
+Chunk Compiler::compile(const Function &function) const {
+  Chunk chunk;
+  for (const Node &statement : function.body) {
+    compileStatement(statement, function, chunk);
+  }
+  // functions without a return statement return nothing
+  emit(chunk, Op::Constant, constant(Value(), chunk));
+  emit(chunk, Op::Return);
+  chunk.callees =
+      std::make_unique<std::atomic<const Function *>[]>(chunk.constants.size());
+  return chunk;
+}
+
+/**
+ * resolve- gives the parameters and the variables declared in the body of a
+ * function fixed frame slots, and marks the words that read them
+ * @param function a parsed function, not a subroutine
+ */
+void Compiler::resolve(Function &function) const {
+  for (const Parameter &parameter : function.parameters) {
+    function.layout.add(parameter.symbol);
+  }
+  declareLocals(function.body, function.layout);
+  resolveWords(function.body, function.layout);
+}
+
+void Compiler::declareLocals(const std::vector<Node> &nodes,
+                             Layout &layout) const {
+  for (const Node &node : nodes) {
+    if (node.type != NodeType::Expression) {
+      continue;
+    }
+    const std::vector<Node> &words = node.children;
+    if (words.size() >= 2 && words[0].type == NodeType::Word &&
+        (isDeclaration(words[0].builtin) ||
+         words[0].builtin == Builtin::Read) &&
+        words[1].type == NodeType::Word) {
+      layout.add(words[1].symbol);
+    }
+    declareLocals(words, layout);
+  }
+}
+
+void Compiler::resolveWords(std::vector<Node> &nodes,
+                            const Layout &layout) const {
+  for (Node &node : nodes) {
+    if (node.type == NodeType::Word) {
+      node.slot = layout.find(node.symbol);
+    } else if (node.type == NodeType::Expression) {
+      // list elements and nested definitions are not part of this frame
+      resolveWords(node.children, layout);
+    }
+  }
+}
+
+void Compiler::compileStatement(const Node &statement,
+                                const Function &function, Chunk &chunk) const {
+  const Node &command = statement.children[0];
+  if (command.type == NodeType::Word && command.text == "return" &&
+      function.kind != FunctionKind::Subroutine) {
+    if (statement.children.size() > 1) {
+      compileArgument(statement.children[1], chunk, true);
+    } else {
+      emit(chunk, Op::Constant, constant(Value(), chunk));
+    }
+    emit(chunk, Op::Return);
+  } else {
+    compileExpression(statement, chunk);
+    emit(chunk, Op::Pop);
+  }
+}
+
+/**
+ * compileExpression- emits code that leaves the value of the expression on
+ * the stack
+ * @param expression the expression
+ * @param chunk where the code goes
+ * @param tail if the value is returned as soon as it is computed, calls made
+ * in tail position reuse the frame of the caller
+ */
+void Compiler::compileExpression(const Node &expression, Chunk &chunk,
+                                 bool tail) const {
+  const std::vector<Node> &words = expression.children;
+  if (words.empty()) {
+    emit(chunk, Op::Constant, constant(Value(), chunk));
+    return;
+  } else if (words[0].type == NodeType::Expression) {
+    compileExpression(words[0], chunk, tail);
+    return;
+  } else if (words[0].type != NodeType::Word) {
+    fallback(expression, chunk);
+    return;
+  }
+  const std::string &name = words[0].text;
+  const Builtin builtin = words[0].builtin;
+  if (builtin == Builtin::If) {
+    if (words.size() != 4) {
+      fallback(expression, chunk);
+      return;
+    }
+    compileArgument(words[1], chunk);
+    uint32_t iffalse = emit(chunk, Op::JumpIfFalse);
+    compileArgument(words[2], chunk, tail);
+    uint32_t end = emit(chunk, Op::Jump);
+    chunk.code[iffalse].a = chunk.code.size();
+    compileArgument(words[3], chunk, tail);
+    chunk.code[end].a = chunk.code.size();
+  } else if (isDeclaration(builtin)) {
+    if (words.size() != 3 || words[1].type != NodeType::Word) {
+      fallback(expression, chunk);
+      return;
+    }
+    compileArgument(words[2], chunk);
+    emit(chunk, Op::Declare, constant(Value::string(name), chunk),
+         words[1].symbol);
+  } else if (builtin != Builtin::None) {
+    if (builtin == Builtin::Read || builtin == Builtin::Define ||
+        builtin == Builtin::Defmem || builtin == Builtin::Subroutine ||
+        builtin == Builtin::Return || builtin == Builtin::End) {
+      fallback(expression, chunk);
+      return;
+    }
+    for (auto word = words.begin() + 1; word != words.end(); ++word) {
+      compileArgument(*word, chunk);
+    }
+    emit(chunk, Op::CallBuiltIn, static_cast<uint32_t>(builtin),
+         words.size() - 1);
+  } else {
+    for (auto word = words.begin() + 1; word != words.end(); ++word) {
+      compileArgument(*word, chunk);
+    }
+    emit(chunk, tail ? Op::TailCall : Op::Call,
+         constant(Value::string(name), chunk), words.size() - 1);
+  }
+}
+
+void Compiler::compileArgument(const Node &argument, Chunk &chunk,
+                               bool tail) const {
+  switch (argument.type) {
+  case NodeType::Expression:
+    compileExpression(argument, chunk, tail);
+    break;
+  case NodeType::Definition:
+    fallback(argument, chunk);
+    break;
+  case NodeType::Literal:
+  case NodeType::List:
+    emit(chunk, Op::Constant, constant(argument.value, chunk));
+    break;
+  case NodeType::Word:
+    emit(chunk, Op::Load, argument.symbol, argument.slot);
+    break;
+  }
+}
+
+/**
+ * fallback- leaves a node the compiler does not handle to the tree walker
+ * @param node the node
+ * @param chunk where the code goes
+ */
+void Compiler::fallback(const Node &node, Chunk &chunk) const {
+  chunk.nodes.push_back(node);
+  emit(chunk, Op::Eval, chunk.nodes.size() - 1);
+}
+
+uint32_t Compiler::constant(const Value &value, Chunk &chunk) const {
+  for (uint32_t i = 0; i < chunk.constants.size(); ++i) {
+    if (chunk.constants[i] == value) {
+      return i;
+    }
+  }
+  chunk.constants.push_back(value);
+  return chunk.constants.size() - 1;
+}
+
+uint32_t Compiler::emit(Chunk &chunk, Op op, uint32_t a, uint32_t b) const {
+  chunk.code.push_back(Instruction{op, a, b});
+  return chunk.code.size() - 1;
+}
+
+bool Compiler::isDeclaration(Builtin builtin) const {
+  return builtin == Builtin::String || builtin == Builtin::Boolean ||
+         builtin == Builtin::Num || builtin == Builtin::List;
+}
@@ -0,0 +1,39 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Compiler.h
+ */
+
+#ifndef MONET_COMPILER_H
+#define MONET_COMPILER_H
+
+#include "Bytecode.h"
+#include "Memory.h"
+#include "Node.h"
+
+class Compiler {
+public:
+  explicit Compiler(const Memory &memory);
+  Chunk compile(const Function &function) const;
+  void resolve(Function &function) const;
+
+private:
+  void declareLocals(const std::vector<Node> &nodes, Layout &layout) const;
+  void resolveWords(std::vector<Node> &nodes, const Layout &layout) const;
+  void compileStatement(const Node &statement, const Function &function,
+                        Chunk &chunk) const;
+  void compileExpression(const Node &expression, Chunk &chunk,
+                         bool tail = false) const;
+  void compileArgument(const Node &argument, Chunk &chunk,
+                       bool tail = false) const;
+  void fallback(const Node &node, Chunk &chunk) const;
+  uint32_t constant(const Value &value, Chunk &chunk) const;
+  uint32_t emit(Chunk &chunk, Op op, uint32_t a = 0, uint32_t b = 0) const;
+  bool isDeclaration(Builtin builtin) const;
+
+  const Memory &memory;
+};
+
+#endif // MONET_COMPILER_H
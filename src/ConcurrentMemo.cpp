@@ -0,0 +1,201 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: ConcurrentMemo.cpp
+ */
+
+#include "ConcurrentMemo.h"
+#include <algorithm>
+
+namespace {
+// the smallest share of a budget worth giving a shard of its own
+const size_t SHARD_BUDGET = 64 << 10;
+} // namespace
+
+/**
+ * setbudget- called before any result is remembered
+ * @param total the most bytes all memoized results may take, 0 for no limit
+ * @param perfunction the most bytes the results of one function may take, 0
+ * for no limit
+ * Each shard in use keeps to an even share of the budgets.
+ */
+void ConcurrentMemo::setbudget(size_t total, size_t perfunction) {
+  size_t smallest = std::min(total != 0 ? total : SIZE_MAX,
+                             perfunction != 0 ? perfunction : SIZE_MAX);
+  used = std::max<size_t>(1, std::min(SHARDS, smallest / SHARD_BUDGET));
+  for (size_t x = 0; x < used; ++x) {
+    std::lock_guard<std::mutex> guard(shards[x].lock);
+    shards[x].table.setbudget(total / used, perfunction / used);
+  }
+}
+
+/**
+ * setwaiting
+ * @param wait if a miss on a call another thread is computing waits for its
+ * result
+ */
+void ConcurrentMemo::setwaiting(bool wait) { waiting = wait; }
+
+/**
+ * find
+ * @param name a memoized function
+ * @param call the arguments of the call
+ * @param result set to the remembered result on a hit
+ * @return true on a hit. When waiting, a miss means the calling thread now
+ * computes the call and must insert or abandon it.
+ */
+bool ConcurrentMemo::find(const std::string &name,
+                          const std::vector<Value> &call, Value &result) {
+  const size_t key = hash(name, call);
+  Shard &part = shard(key);
+  std::unique_lock<std::mutex> guard(part.lock);
+  if (waiting) {
+    const std::thread::id self = std::this_thread::get_id();
+    // a thread asking again for a call it is computing recurses forever,
+    // that is left to the depth limit rather than to a deadlock
+    part.published.wait(guard, [&] {
+      auto other = computing(part, key, name, call);
+      return other == part.computing.end() || other->second.owner == self;
+    });
+    const Value *found = part.table.find(name, call);
+    if (found != nullptr) {
+      result = *found;
+      return true;
+    }
+    // only a miss copies the call, the thread computing it then owns it
+    part.computing.emplace(key, Computing{name, call, self});
+    return false;
+  }
+  const Value *found = part.table.find(name, call);
+  if (found != nullptr) {
+    result = *found;
+  }
+  return found != nullptr;
+}
+
+void ConcurrentMemo::insert(const std::string &name,
+                            const std::vector<Value> &call,
+                            const Value &result) {
+  const size_t key = hash(name, call);
+  Shard &part = shard(key);
+  std::lock_guard<std::mutex> guard(part.lock);
+  part.table.insert(name, call, result);
+  release(part, key, name, call);
+}
+
+/**
+ * abandon- called when a call that missed ends without a result, threads
+ * waiting on it compute it themselves
+ */
+void ConcurrentMemo::abandon(const std::string &name,
+                             const std::vector<Value> &call) {
+  const size_t key = hash(name, call);
+  Shard &part = shard(key);
+  std::lock_guard<std::mutex> guard(part.lock);
+  release(part, key, name, call);
+}
+
+MemoStats ConcurrentMemo::stats(const std::string &name) const {
+  MemoStats total;
+  for (size_t x = 0; x < used; ++x) {
+    std::lock_guard<std::mutex> guard(shards[x].lock);
+    MemoStats part = shards[x].table.stats(name);
+    total.hits += part.hits;
+    total.misses += part.misses;
+    total.evictions += part.evictions;
+    total.entries += part.entries;
+    total.bytes += part.bytes;
+  }
+  return total;
+}
+
+MemoStats ConcurrentMemo::stats() const {
+  MemoStats total;
+  for (size_t x = 0; x < used; ++x) {
+    std::lock_guard<std::mutex> guard(shards[x].lock);
+    MemoStats part = shards[x].table.stats();
+    total.hits += part.hits;
+    total.misses += part.misses;
+    total.evictions += part.evictions;
+    total.entries += part.entries;
+    total.bytes += part.bytes;
+  }
+  return total;
+}
+
+std::vector<std::string> ConcurrentMemo::functions() const {
+  std::vector<std::string> names;
+  for (size_t x = 0; x < used; ++x) {
+    std::lock_guard<std::mutex> guard(shards[x].lock);
+    for (const std::string &name : shards[x].table.functions()) {
+      names.push_back(name);
+    }
+  }
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+  return names;
+}
+
+/**
+ * entries
+ * @param name a memoized function
+ * @return its remembered results, the most recently used first within each
+ * shard
+ */
+std::vector<MemoEntry>
+ConcurrentMemo::entries(const std::string &name) const {
+  std::vector<MemoEntry> results;
+  for (size_t x = 0; x < used; ++x) {
+    std::lock_guard<std::mutex> guard(shards[x].lock);
+    std::vector<MemoEntry> part = shards[x].table.entries(name);
+    std::move(part.begin(), part.end(), std::back_inserter(results));
+  }
+  return results;
+}
+
+/**
+ * hash
+ * @param name a memoized function
+ * @param call the arguments of the call
+ * @return the hash that picks the shard of the call and files it while it
+ * is computed, taken without copying either
+ */
+size_t ConcurrentMemo::hash(const std::string &name,
+                            const std::vector<Value> &call) {
+  return std::hash<std::string>()(name) * 31 + MemoTable::KeyHash()(call);
+}
+
+ConcurrentMemo::Shard &ConcurrentMemo::shard(size_t hash) {
+  if (used == 1) {
+    return shards[0];
+  }
+  // the low bits of the hash pick the bucket inside the shard
+  return shards[(hash >> 8) % used];
+}
+
+ConcurrentMemo::ComputingMap::iterator
+ConcurrentMemo::computing(Shard &part, size_t hash, const std::string &name,
+                          const std::vector<Value> &call) {
+  auto range = part.computing.equal_range(hash);
+  for (auto other = range.first; other != range.second; ++other) {
+    if (other->second.name == name && other->second.call == call) {
+      return other;
+    }
+  }
+  return part.computing.end();
+}
+
+void ConcurrentMemo::release(Shard &part, size_t hash,
+                             const std::string &name,
+                             const std::vector<Value> &call) {
+  if (!waiting) {
+    return;
+  }
+  auto other = computing(part, hash, name, call);
+  if (other != part.computing.end()) {
+    part.computing.erase(other);
+    part.published.notify_all();
+  }
+}
@@ -0,0 +1,77 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: ConcurrentMemo.h
+ */
+
+#ifndef MONET_CONCURRENTMEMO_H
+#define MONET_CONCURRENTMEMO_H
+
+#include "MemoTable.h"
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * ConcurrentMemo- the memo table shared by an interpreter and its workers
+ * Results are spread over shards by their function and arguments, and every
+ * shard has a lock of its own, so threads only wait for each other when
+ * their calls land in the same shard. With waiting turned on a thread that
+ * misses on a call another thread is computing waits for that result
+ * instead of computing it again.
+ */
+class ConcurrentMemo {
+public:
+  void setbudget(size_t total, size_t perfunction);
+  void setwaiting(bool wait);
+
+  bool find(const std::string &name, const std::vector<Value> &call,
+            Value &result);
+  void insert(const std::string &name, const std::vector<Value> &call,
+              const Value &result);
+  void abandon(const std::string &name, const std::vector<Value> &call);
+
+  MemoStats stats(const std::string &name) const;
+  MemoStats stats() const;
+  std::vector<std::string> functions() const;
+  std::vector<MemoEntry> entries(const std::string &name) const;
+
+private:
+  // a call some thread is computing, filed under the hash of the call
+  struct Computing {
+    std::string name;
+    std::vector<Value> call;
+    std::thread::id owner;
+  };
+  typedef std::unordered_multimap<size_t, Computing> ComputingMap;
+  struct Shard {
+    mutable std::mutex lock;
+    std::condition_variable published;
+    MemoTable table;
+    // calls a thread has missed on and is computing, only kept when waiting
+    ComputingMap computing;
+  };
+
+  static constexpr size_t SHARDS = 16;
+
+  static size_t hash(const std::string &name, const std::vector<Value> &call);
+  Shard &shard(size_t hash);
+  static ComputingMap::iterator computing(Shard &part, size_t hash,
+                                          const std::string &name,
+                                          const std::vector<Value> &call);
+  void release(Shard &part, size_t hash, const std::string &name,
+               const std::vector<Value> &call);
+
+  std::array<Shard, SHARDS> shards;
+  // shards in use, fewer when a small budget would not fit in a sixteenth
+  size_t used = SHARDS;
+  bool waiting = false;
+};
+
+#endif // MONET_CONCURRENTMEMO_H
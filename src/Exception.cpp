@@ -12,3 +12,7 @@ Exception::Exception(const std::string &ErrorMessage)
     : errormessage(ErrorMessage) {}
 
 std::string Exception::what() { return errormessage; }
+
+Quit::Quit(int status) : code(status) {}
+
+int Quit::status() const { return code; }
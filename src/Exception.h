@@ -21,4 +21,17 @@ private:
   const std::string errormessage;
 };
 
+/**
+ * Quit- thrown by the quit builtin, the host of the interpreter decides what
+ * quitting means, the Monet executable exits with the status
+ */
+class Quit {
+public:
+  explicit Quit(int status);
+  int status() const;
+
+private:
+  int code;
+};
+
 #endif // MONET_EXCEPTION_H
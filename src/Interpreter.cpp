@@ -7,929 +7,1247 @@
  */
 
 #include "Interpreter.h"
+#include "Source.h"
+#include "ThreadPool.h"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iterator>
 #include <numeric>
 #include <sstream>
 
-const char ENDOFFUN = '\17';
 const std::string REPLPROMPT = "> ";
+// preduce splits its list into at most this many runs, whatever the machine,
+// so that it combines results in the same order everywhere
+const size_t PREDUCE_LEAVES = 64;
+// each reads its input and writes its results in pieces of this size
+const size_t EACH_CHUNK = 1 << 16;
 
 /**
- * Default constructor
- * Used when using the REPL
+ * unevaluated
+ * @param value a value
+ * @return if it is a list holding parenthesised elements, nested lists
+ * included
  */
-Interpreter::Interpreter() { repl(); }
+bool unevaluated(const Value &value) {
+  if (!value.isList()) {
+    return false;
+  }
+  for (const Cell *cell = value.asList().get(); cell != nullptr;
+       cell = cell->tail.get()) {
+    if (cell->expression || unevaluated(cell->head)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// the options of a worker, which leaves reporting to its parent and runs
+// parallel builtins nested in its tasks by itself
+Options quiet(Options options) {
+  options.memoStats = false;
+  options.profile = false;
+  options.trace = "";
+  options.memoCache = "";
+  options.moduleCache = "";
+  options.threads = 1;
+  return options;
+}
 
 /**
  * Constructor
- * @param filename - the file you want to interpret
+ * Nothing runs until repl, runFile, runSource or callFunction is called, and
+ * the definitions and variables of one run are there for the next.
+ * @param options - how the interpreter runs
  */
-Interpreter::Interpreter(std::string filename) {
-  code = loadCodeFromFile(filename);
-  interpret();
+Interpreter::Interpreter(const Options &options)
+    : parser(*memory.symboltable()), compiler(memory), vm(*this),
+      options(options), printing(std::make_shared<std::mutex>()) {
+  memory.seterrors(options.errors);
+  memory.setmembudget(options.memoBudget, options.memoFunctionBudget);
+  memory.setmemwaiting(options.memoWait);
+  memory.setmaxdepth(options.maxDepth);
+  if (options.memoCache != "") {
+    memory.setmemcache(options.memoCache);
+  }
+  if (options.moduleCache != "") {
+    modules = std::make_unique<ModuleCache>(
+        options.moduleCache, *options.errors, *memory.symboltable());
+  }
+  if (options.profile) {
+    profiler = std::make_unique<Profiler>();
+  }
+  if (options.trace != "") {
+    tracer = std::make_shared<Tracer>();
+    memory.settracer(tracer.get());
+  }
 }
 
 /**
- * interpret function- essentially iterates over the code and runs eval on each
- * line
+ * Worker constructor
+ * Used by the parallel builtins, a worker runs functions of its parent on a
+ * thread of its own. It has its own frames and shares the definitions and
+ * memo table of the parent, it reports nothing when it is done.
+ * @param parent the interpreter the worker helps
  */
-void Interpreter::interpret() {
-  std::for_each(code.begin(), code.end(),
-                [&](std::string line) -> void { eval(line); });
+Interpreter::Interpreter(const Interpreter &parent, Worker)
+    : memory(parent.memory.symboltable()), parser(*memory.symboltable()),
+      compiler(memory), vm(*this), options(quiet(parent.options)),
+      printing(parent.printing), tracer(parent.tracer), worker(true) {
+  memory.share(parent.memory);
 }
 
-void Interpreter::repl() {
-  std::string function;
-  bool inFunction = false;
-  while (true) {
-    std::cout << REPLPROMPT << std::flush;
-    std::string input;
-    std::getline(std::cin, input);
-    if (input == "") {
-      continue;
-    }
-    if (input.substr(0, FUNCTION_DECLARATION_NAME.length()) ==
-            FUNCTION_DECLARATION_NAME ||
-        input.substr(0, SUBROUTINE_DECLARATION_NAME.length()) ==
-            SUBROUTINE_DECLARATION_NAME ||
-        input.substr(0, MEM_DECLARATION_NAME.length()) ==
-            MEM_DECLARATION_NAME) {
-      inFunction = true;
-    }
-    if (input.substr(0, FUNCTION_END_NAME.length()) == FUNCTION_END_NAME) {
-      inFunction = false;
-      std::cout << eval(function) << std::endl;
-      function = "";
-      continue;
-    }
-    if (!inFunction) {
-      std::cout << eval(input) << std::endl;
-    } else {
-      function += input + ENDOFFUN;
-    }
+/**
+ * Destructor- finishes an interpreter its host did not finish, errors doing
+ * so are dropped since a destructor cannot throw them
+ */
+Interpreter::~Interpreter() {
+  if (worker || finished) {
+    return;
+  }
+  try {
+    finish();
+  } catch (...) {
   }
 }
 
 /**
- * load code from file
- * @param filename the file you want to load from
- * @return a vector of strings where each line is the code;
+ * finish- writes out the output and reports and saves what should outlive
+ * the run, called by the host once the program ends or quits. Only the first
+ * call does anything.
+ * @throws what writing to the streams or files of the options throws
  */
-std::vector<std::string>
-Interpreter::loadCodeFromFile(const std::string &filename) {
-  std::vector<std::string> loadedcode;
-  std::ifstream infile;
-  infile.open(filename);
-  std::string line;
-  std::string fn;
-  bool inFunction = false;
-  while (std::getline(infile, line)) {
-    // Some logic to make it so function declarations are not split up
-    if (line.substr(0, FUNCTION_DECLARATION_NAME.length()) ==
-            FUNCTION_DECLARATION_NAME ||
-        line.substr(0, SUBROUTINE_DECLARATION_NAME.length()) ==
-            SUBROUTINE_DECLARATION_NAME ||
-        line.substr(0, MEM_DECLARATION_NAME.length()) == MEM_DECLARATION_NAME) {
-      inFunction = true;
-    }
-    if (line.substr(0, FUNCTION_END_NAME.length()) == FUNCTION_END_NAME) {
-      inFunction = false;
-      loadedcode.push_back(fn);
-      fn = "";
-      continue;
-    }
-    if (inFunction) {
-      fn += line;
-      // Use end of transmission character in between each line
-      fn += ENDOFFUN;
-    } else {
-      if (line == "") {
-        // Do nothing on empty lines
-        continue;
-      }
-      loadedcode.push_back(line);
-    }
+void Interpreter::finish() {
+  if (finished) {
+    return;
+  }
+  finished = true;
+  flush();
+  if (profiler) {
+    printprofile();
+  }
+  if (tracer && options.trace != "") {
+    tracer->save(options.trace, *options.errors);
   }
-  return loadedcode;
+  if (options.memoStats) {
+    printmemstats();
+  }
+  memory.savememcache();
 }
 
 /**
- * Eval function
- * @param value the line you want to evauluate
- * @return what the command evaluates to
+ * runFile
+ * @param filename a program to run to its end, its definitions are kept
+ * @throws Exception when the program fails and Quit when it quits, either
+ * way the interpreter can run more code afterwards
  */
-std::string Interpreter::eval(const std::string &value) {
-  std::vector<std::string> words = split(value);
-  if (words.size() == 0) {
-    return "";
-  } else if (words[0].length() > 1 && words[0].substr(0, 2) == "//") {
-    // do nothing, this is a comment
-    return "";
-  } else if (isParens(words[0])) {
-    return eval(removeparens(words[0]));
-  } else if (memory.isBuiltInFn(words[0])) {
-    return evalBuiltIns(value, words);
-  } else if (isLibraryCall(words[0])) {
-
-  } else if (memory.functioninuse(words[0])) {
-    if (memory.isFunction(words[0])) {
-      return call(words);
-    } else if (memory.isSubroutine(words[0])) {
-      return callsubroutine(words[0]);
-    } else if (memory.isMem(words[0])) {
-      return callmem(words);
-    } else {
-      // happens when we are nested in a function
-      std::string fn = memory.getBinding(words[0]);
-      if (memory.isBuiltInFn(fn)) {
-        words[0] = fn;
-        std::string s = "";
-        for (uint32_t i = 0; i < words.size(); ++i) {
-          s += words[i];
-          if (i != words.size() - 1) {
-            s += " ";
-          }
-        }
-        return eval(s);
-      } else if (memory.isFunction(fn)) {
-        return call(words);
-      } else if (memory.isSubroutine(fn)) {
-        return callsubroutine(words[0]);
-      } else if (memory.isMem(fn)) {
-        return callmem(words);
-      }
-    }
-  } else {
-    throw Exception("Function \"" + words[0] + "\" does not exist");
-  }
-  return "";
+void Interpreter::runFile(const std::string &filename) {
+  code = loadCodeFromFile(filename);
+  top([&] {
+    interpret();
+    return Value();
+  });
 }
 
-std::string Interpreter::evalBuiltIns(const std::string &value,
-                                      const std::vector<std::string> &words) {
-  const char FIRSTLETTER = value.at(0);
-  switch (FIRSTLETTER) {
-  case 'a':
-    if (words[0] == "add") {
-      return normalizenumber(add(words));
-    } else if (words[0] == "and") {
-      return normalizebool(andfunc(words));
-    }
-    break;
-  case 'b':
-    if (words[0] == "boolean") {
-      declareboolean(words);
-      return "";
-    }
-    break;
-  case 'c':
-    if (words[0] == "cons") {
-      return cons(words);
-    }
-    break;
-  case 'd':
-    if (words[0] == "define") {
-      define(split(value, ENDOFFUN));
-      return "";
-    } else if (words[0] == "defmem") {
-      defmem(split(value, ENDOFFUN));
-      return "";
-    } else if (words[0] == "div") {
-      return normalizenumber(div(words));
-    }
-    break;
-  case 'e':
-    if (words[0] == "eq") {
-      return normalizebool(comparison(words) == 0);
-    }
-    break;
-  case 'f':
-    break;
-  case 'g':
-    if (words[0] == "ge") {
-      return normalizebool(comparison(words) >= 0);
-    } else if (words[0] == "gt") {
-      return normalizebool(comparison(words) > 0);
-    }
-    break;
-  case 'h':
-    if (words[0] == "head") {
-      return head(words);
-    }
-    break;
-  case 'i':
-    if (words[0] == "if") {
-      return ifstatement(words);
-    } else if (words[0] == "import") {
-      return import(words);
-    }
-    break;
-  case 'j':
-    break;
-  case 'k':
-    break;
-  case 'l':
-    if (words[0] == "le") {
-      return normalizebool(comparison(words) <= 0);
-    } else if (words[0] == "list") {
-      declarelist(words);
-      return "";
-    } else if (words[0] == "load") {
-      load(words);
-      return "";
-    } else if (words[0] == "lt") {
-      return normalizebool(comparison(words) < 0);
-    }
-    break;
-  case 'm':
-    if (words[0] == "mul") {
-      return normalizenumber(mul(words));
-    }
-    break;
-  case 'n':
-    if (words[0] == "nand") {
-      return normalizebool(nandfunc(words));
-    } else if (words[0] == "ne") {
-      return normalizebool(comparison(words) != 0);
-    } else if (words[0] == "nor") {
-      return normalizebool(norfunc(words));
-    } else if (words[0] == "not") {
-      return normalizebool(notfunc(words));
-    } else if (words[0] == "null") {
-      return normalizebool(isNull(words));
-    } else if (words[0] == "num") {
-      declarenum(words);
-      return "";
-    }
-    break;
-  case 'o':
-    if (words[0] == "or") {
-      return normalizebool(orfunc(words));
-    }
-    break;
-  case 'p':
-    if (words[0] == "print") {
-      print(words);
-      return "";
-    } else if (words[0] == "println") {
-      println(words);
-      return "";
-    } else if (words[0] == "printall") {
-      printcode();
-      return "";
-    }
-    break;
-  case 'q':
-    if (words[0] == "quit") {
-      quit(words);
-      return "";
-    }
-    break;
-  case 'r':
-    if (words[0] == "read") {
-      return read(words);
-    }
-    break;
-  case 's':
-    if (words[0] == "string") {
-      declarestring(words);
-      return "";
-    } else if (words[0] == "sub") {
-      return normalizenumber(sub(words));
-    } else if (words[0] == "subroutine") {
-      subroutine(split(value, ENDOFFUN));
-      return "";
-    }
-    break;
-  case 't':
-    if (words[0] == "tail") {
-      return tail(words);
-    }
-    break;
-  case 'u':
-    break;
-  case 'v':
-    break;
-  case 'w':
-    break;
-  case 'x':
-    if (words[0] == "xnor") {
-      return normalizebool(xnorfunc(words));
-    } else if (words[0] == "xor") {
-      return normalizebool(xorfunc(words));
+/**
+ * runSource
+ * @param source lines of Monet, run like a file
+ * @return the value of the last statement
+ */
+Value Interpreter::runSource(const std::string &source) {
+  std::vector<Node> statements = parser.parse(std::string_view(source));
+  return top([&] {
+    Value last;
+    for (const Node &statement : statements) {
+      last = eval(statement);
     }
-    break;
-  case 'y':
-    break;
-  case 'z':
-    break;
-  default:
-    if (words[0] == "<=>") {
-      return std::to_string(comparison(words));
+    return last;
+  });
+}
+
+/**
+ * callFunction
+ * @param name a builtin, or a function, subroutine or memoized function
+ * defined so far
+ * @param args its parameters, converted to the types it declares
+ * @return what the function returns
+ */
+Value Interpreter::callFunction(const std::string &name,
+                                const std::vector<Value> &args) {
+  return top([&] {
+    Builtin builtin = Builtins::find(name);
+    if (builtin != Builtin::None) {
+      return callBuiltIn(builtin, args);
     }
-  }
-  throw Exception("Fatal implementation error in evalBuiltIns. The standard "
-                  "library is flawed.");
+    return invoke(name, args);
+  });
 }
 
 /**
- * printcode- a function that prints the code, really just for debugging
+ * defineNative- adds a C++ function Monet code can call
+ * @param name library.function, calls in Monet use this name
+ * @param types num, string, boolean, list or fn for every parameter, the
+ * arguments are converted to them before the body is called
+ * @param body the function, it throws Exception for errors
+ * @throws Exception if the name is not library.function, a type does not
+ * exist or the name is taken
  */
-void Interpreter::printcode() {
-  std::copy(code.begin(), code.end(),
-            std::ostream_iterator<std::string>(std::cout, "\n"));
+void Interpreter::defineNative(const std::string &name,
+                               const std::vector<std::string> &types,
+                               Native body) {
+  memory.createnative(name, types, std::move(body));
 }
 
 /**
- * split function
- * @param str string you want to split
- * @param delim the delim char that is used to split words, default = ' '
- * @return a vector of strings, each is one statement (can be a string,
- * parenthesised statement, or just a value)
+ * each- runs a function on every line of the input, like awk
+ * @param name a function of one parameter, it gets the line without its end
+ * @return the number of lines
+ * What the function returns is written out as a line of its own. A function
+ * returning a boolean filters instead, the lines it returns true for are
+ * written as they are. Nothing is written for a function returning nothing.
  */
-std::vector<std::string> Interpreter::split(const std::string &str,
-                                            char delim) const {
-  std::vector<std::string> returnval;
-  std::string temp = "";
-  bool instr = false;
-  int inparens = 0;
-  int inlist = 0;
-  for (uint32_t i = 0; i < str.length(); ++i) {
-    if (str[i] == '(' && !instr) {
-      ++inparens;
-    }
-    if (str[i] == ')' && !instr) {
-      --inparens;
-    }
-    if (str[i] == '[' && !instr) {
-      ++inlist;
-    }
-    if (str[i] == ']' && !instr) {
-      --inlist;
+size_t Interpreter::each(const std::string &name) {
+  const Callee callee = resolve(Value::function(name));
+  if (callee.builtin == Builtin::None && !memory.functioninuse(name)) {
+    throw Exception("Function \"" + name + "\" does not exist");
+  }
+  if (callee.function != nullptr && callee.function->parameters.size() != 1) {
+    throw Exception("Function " + name +
+                    " must take one parameter to run on every line");
+  }
+  size_t lines = 0;
+  top([&] {
+    std::istream &input = *options.input;
+    // one argument vector for all lines, the frame stack keeps its capacity
+    // so calls after the first do not allocate for the frame either
+    std::vector<Value> args(1);
+    std::vector<char> chunk(EACH_CHUNK);
+    std::string carry;
+    flush();
+    while (input.read(chunk.data(), chunk.size()) || input.gcount() > 0) {
+      const char *data = chunk.data();
+      const char *end = data + input.gcount();
+      const char *newline;
+      while ((newline = static_cast<const char *>(
+                  std::memchr(data, '\n', end - data))) != nullptr) {
+        if (carry.empty()) {
+          record(std::string_view(data, newline - data), callee, args);
+        } else {
+          carry.append(data, newline);
+          record(carry, callee, args);
+          carry.clear();
+        }
+        ++lines;
+        data = newline + 1;
+      }
+      carry.append(data, end);
     }
-    if (str[i] == '"') {
-      instr = !instr;
+    if (!carry.empty()) {
+      record(carry, callee, args);
+      ++lines;
     }
-    if (str[i] == delim && temp != "" && !instr && inparens == 0 &&
-        inlist == 0) {
-      returnval.push_back(temp);
-      temp = "";
-    } else if (inparens != 0 || inlist != 0) {
-      temp += str[i];
-    } else if (instr) {
-      temp += str[i];
-    } else {
-      temp += tolower(str[i]);
+    flush();
+    return Value();
+  });
+  return lines;
+}
+
+/**
+ * record- runs the function of each on one line
+ * @param line the line, a carriage return at its end is dropped
+ * @param callee the function
+ * @param args the argument vector the line is passed in
+ */
+void Interpreter::record(std::string_view line, const Callee &callee,
+                         std::vector<Value> &args) {
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+  args[0] = Value::string(std::string(line));
+  const Value result = apply(callee, args);
+  if (result.isBoolean()) {
+    if (result.asBoolean()) {
+      pending.append(line);
+      pending += '\n';
     }
+  } else if (!result.isNone()) {
+    pending += result.str();
+    pending += '\n';
   }
-  if (temp != "") {
-    returnval.push_back(temp);
+  if (pending.size() >= EACH_CHUNK || options.unbuffered) {
+    flush();
   }
-  returnval.erase(std::remove_if(returnval.begin(), returnval.end(),
-                                 [](std::string x) -> bool {
-                                   return (x == "" || x == " ");
-                                 }),
-                  returnval.end());
-  return returnval;
 }
 
 /**
- * list split function
- * @param list the list you want to split
- * @return a pair where first is the head, second is the tail
+ * top- runs code started from outside the interpreter
+ * @param body the code
+ * @return what the code returns
+ * The native stack is measured from here. When the code throws, quitting
+ * included, the calls it was in are left so that the interpreter is back at
+ * the top level. Native functions calling back into the interpreter run
+ * inside the call that is already running.
  */
-std::pair<std::string, std::string>
-Interpreter::listSplit(const std::string &list) const {
-  if (!isList(list)) {
-    throw Exception("Unable to parse a non list as a list");
-  }
-  std::string rawlist = removelist(strtolist(list));
-  std::string head, tail;
-  if (rawlist == "") {
-    head = "";
-    tail = " ";
-  } else {
-    size_t index = std::string::npos;
-    int nestcount = 0;
-    int parencount = 0;
-    for (uint32_t i = 0; i < rawlist.length(); ++i) {
-      if (rawlist.at(i) == '[') {
-        ++nestcount;
-      } else if (rawlist.at(i) == ']') {
-        --nestcount;
-      } else if (rawlist.at(i) == '(') {
-        ++parencount;
-      } else if (rawlist.at(i) == ')') {
-        --parencount;
-      } else if (rawlist.at(i) == ' ' && nestcount == 0 && parencount == 0) {
-        index = i;
-        break;
-      }
-    }
-    if (index == std::string::npos) {
-      head = rawlist;
-      tail = "[]";
-    } else {
-      head = rawlist.substr(0, index);
-      tail = "[" + rawlist.substr(index + 1) + "]";
+Value Interpreter::top(const std::function<Value()> &body) {
+  if (running) {
+    // called back from a native function, the outermost call recovers
+    return body();
+  }
+  char marker;
+  stackstart = reinterpret_cast<uintptr_t>(&marker);
+  running = true;
+  try {
+    Value result = body();
+    running = false;
+    return result;
+  } catch (...) {
+    running = false;
+    memory.leaveall();
+    tailcall.function = nullptr;
+    if (profiler) {
+      profiler->stop();
     }
+    throw;
   }
-  return std::pair<std::string, std::string>(head, tail);
 }
 
 /**
- * isString function
- * @param val you want to check
- * @return true if val is a string in code
+ * interpret function- essentially iterates over the code and runs eval on each
+ * line
  */
-bool Interpreter::isString(const std::string &val) const {
-  return (val.length() >= 2 && val[0] == '"' && val[val.size() - 1] == '"');
+void Interpreter::interpret() {
+  std::for_each(code.begin(), code.end(),
+                [&](const Node &line) -> void { eval(line); });
 }
 
 /**
- * isList function
- * @param val the value you are testing to be a list
- * @return if the thing passed is a list
+ * repl- reads statements from the input and prints their values until the
+ * input ends
+ * @throws Quit when a statement quits
  */
-bool Interpreter::isList(const std::string &val) const {
-  return (val.length() >= 2 && val[0] == '[' && val[val.size() - 1] == ']');
-  ;
+void Interpreter::repl() {
+  std::vector<std::string> function;
+  bool inFunction = false;
+  top([&] {
+    while (true) {
+      *options.output << REPLPROMPT << std::flush;
+      std::string input;
+      if (!std::getline(*options.input, input)) {
+        return Value();
+      }
+      if (input == "") {
+        continue;
+      }
+      if (parser.startsDefinition(input)) {
+        inFunction = true;
+      }
+      if (inFunction) {
+        function.push_back(input);
+        if (!parser.endsDefinition(input)) {
+          continue;
+        }
+        inFunction = false;
+      } else {
+        function = {input};
+      }
+      std::vector<Node> statements = parser.parse(function);
+      function.clear();
+      if (statements.empty()) {
+        *options.output << std::endl;
+      }
+      for (const Node &statement : statements) {
+        *options.output << eval(statement).str() << std::endl;
+      }
+    }
+  });
 }
 
 /**
- * strtoint
- * @param num you want to convert
- * @return an integer evaluated from the number, only used in quit
+ * load code from file
+ * @param filename the file you want to load from
+ * @return the parsed statements of the file, kept from an earlier run if
+ * there is a module cache
  */
-int Interpreter::strToInt(const std::string &num) const {
-  if (memory.numexists(num)) {
-    return (int)memory.getnum(num);
+std::vector<Node> Interpreter::loadCodeFromFile(const std::string &filename) {
+  if (!profiler) {
+    return readModule(filename);
   }
-  std::stringstream ss(num);
-  int val;
-  ss >> val;
-  return val;
+  // reading and parsing is listed as its own entry of the profile
+  CallScope scope(*this, "parse " + filename);
+  return readModule(filename);
+}
+
+std::vector<Node> Interpreter::readModule(const std::string &filename) const {
+  Source source(filename);
+  std::vector<Node> statements;
+  if (modules && modules->restore(source.text(), statements)) {
+    return statements;
+  }
+  statements = parser.parse(source.text());
+  if (modules && !source.text().empty()) {
+    modules->save(source.text(), statements);
+  }
+  return statements;
 }
 
 /**
- * strtonum
- * @param num you want to convert
- * @return a num that was the string
+ * Eval function
+ * @param value the statement you want to evauluate
+ * @return what the command evaluates to
  */
-num Interpreter::strToNum(const std::string &val) const {
-  if (memory.numexists(val)) {
-    return memory.getnum(val);
+Value Interpreter::eval(const Node &value) {
+  if (value.type == NodeType::Definition) {
+    switch (value.function->kind) {
+    case FunctionKind::Function:
+      define(*value.function);
+      break;
+    case FunctionKind::Memoized:
+      defmem(*value.function);
+      break;
+    case FunctionKind::Subroutine:
+      subroutine(*value.function);
+      break;
+    }
+    return Value();
+  } else if (value.type != NodeType::Expression) {
+    return evalArgument(value);
   }
-  std::stringstream ss(val);
-  num value;
-  ss >> value;
-  return value;
+  const std::vector<Node> &words = value.children;
+  if (words.size() == 0) {
+    return Value();
+  } else if (words[0].type == NodeType::Expression) {
+    return eval(words[0]);
+  } else if (words[0].type != NodeType::Word) {
+    throw Exception("Function \"" + words[0].text + "\" does not exist");
+  }
+  const std::string &name = words[0].text;
+  if (words[0].builtin != Builtin::None) {
+    return evalBuiltIns(words[0].builtin, value);
+  } else if (isLibraryCall(name)) {
+    return invoke(name, evalParameters(value));
+  } else if (memory.functioninuse(name)) {
+    return invoke(name, evalParameters(value));
+  } else {
+    throw Exception("Function \"" + name + "\" does not exist");
+  }
+  return Value();
 }
 
 /**
- * strtobool
- * @param bool you want to convert
- * @return a bool that was the string
+ * invoke- calls a user defined function
+ * @param name the function, subroutine, memoized function, native function
+ * or function parameter
+ * @param params the evaluated parameters
+ * @return what the function returns
  */
-bool Interpreter::strtobool(const std::string &val) const {
-  bool isVariable = memory.boolexists(val);
-  if ((!isVariable) && !isBoolean(val)) {
-    std::cerr << "Calling strtobool on nonboolean value \"" << val << "\""
-              << std::endl;
+Value Interpreter::invoke(const std::string &name,
+                          const std::vector<Value> &params) {
+  // only native functions have a dot in their name
+  if (name.find('.') != std::string::npos) {
+    const NativeFunction *native = memory.findnative(name);
+    if (native != nullptr) {
+      return callNative(*native, params);
+    }
   }
-  if (isVariable) {
-    return memory.getboolean(val);
+  if (memory.isFunction(name)) {
+    return call(name, params);
+  } else if (memory.isSubroutine(name)) {
+    return callsubroutine(name);
+  } else if (memory.isMem(name)) {
+    return callmem(name, params);
+  } else if (memory.isBinding(name)) {
+    // happens when we are nested in a function
+    std::string fn = memory.getBinding(name);
+    Builtin builtin = Builtins::find(fn);
+    if (builtin != Builtin::None) {
+      return callBuiltIn(builtin, params);
+    } else if (fn != name) {
+      return invoke(fn, params);
+    }
   }
-  return (val == "true" || val == "1");
+  throw Exception("Function \"" + name + "\" does not exist");
 }
 
 /**
- * strtostr
- * @param string you want to convert
- * @return a string that was the string, checks variables
+ * callable
+ * @param name the word a call starts with
+ * @return the define or defmem function the call runs, following function
+ * parameters, null for anything else
  */
-std::string Interpreter::strtostr(const std::string &var) const {
-  if (memory.strexists(var)) {
-    return memory.getstring(var);
-  } else if (isString(var)) {
-    return removequotes(var);
-  } else {
-    return var;
+const Function *Interpreter::callable(const std::string &name) const {
+  const Function *function = memory.findfn(name);
+  if (function == nullptr && !memory.isSubroutine(name) &&
+      memory.isBinding(name)) {
+    const std::string target = memory.getBinding(name);
+    return target != name ? callable(target) : nullptr;
   }
+  return function;
 }
 
 /**
- * strtostr
- * @param string you want to convert
- * @return a list that was the string, checks variables
+ * evalBuiltIns- runs a builtin, the forms that need their parameters
+ * unevaluated are handled here
+ * @param builtin the builtin named by the first word of the expression
+ * @param expression the whole expression
+ * @return what the builtin evaluates to
  */
-std::string Interpreter::strtolist(const std::string &val) const {
-  return memory.listexists(val) ? memory.getlist(val) : val;
-}
-
-std::string Interpreter::normalize(const std::string &val) const {
-  if (memory.varexists(val)) {
-    std::string type = memory.getType(val);
-    if (type == "num") {
-      return normalizenumber(strToNum(val));
-    } else if (type == "boolean") {
-      return normalizebool(strtobool(val));
-    } else if (type == "string") {
-      return strtostr(val);
-    } else if (type == "list") {
-      return strtolist(val);
-    } else {
-      throw Exception("Fatal implementation error");
-    }
-  } else {
-    if (isNumber(val)) {
-      return normalizenumber(strToNum(val));
-    } else if (isBoolean(val)) {
-      return normalizebool(strtobool(val));
-    }
+Value Interpreter::evalBuiltIns(Builtin builtin, const Node &expression) {
+  switch (builtin) {
+  case Builtin::Boolean:
+    declareboolean(expression);
+    return Value();
+  case Builtin::If:
+    return ifstatement(expression);
+  case Builtin::List:
+    declarelist(expression);
+    return Value();
+  case Builtin::Num:
+    declarenum(expression);
+    return Value();
+  case Builtin::Read:
+    return read(expression);
+  case Builtin::String:
+    declarestring(expression);
+    return Value();
+  default:
+    return callBuiltIn(builtin, evalParameters(expression));
   }
-  return val;
 }
 
-std::string Interpreter::removequotes(const std::string &original) const {
-  if (isString(original)) {
-    return original.substr(1, original.length() - 2);
-  } else {
-    return original;
+/**
+ * callBuiltIn- runs a builtin whose parameters are already evaluated
+ * @param builtin the builtin
+ * @param params the evaluated parameters
+ * @return what the builtin evaluates to
+ */
+Value Interpreter::callBuiltIn(Builtin builtin,
+                               const std::vector<Value> &params) {
+  if (profiler) {
+    return profileBuiltIn(builtin, params);
   }
+  return runBuiltIn(builtin, params);
 }
 
-bool Interpreter::isParens(const std::string &statement) const {
-  return (statement.length() >= 2 && statement[0] == '(' &&
-          statement[statement.size() - 1] == ')');
+/**
+ * profileBuiltIn- runBuiltIn timed by the profiler, kept apart so that
+ * callBuiltIn takes no more native stack when not profiling
+ */
+Value Interpreter::profileBuiltIn(Builtin builtin,
+                                  const std::vector<Value> &params) {
+  CallScope scope(*this, Builtins::name(builtin));
+  return runBuiltIn(builtin, params);
+}
+
+Value Interpreter::runBuiltIn(Builtin builtin,
+                              const std::vector<Value> &params) {
+  switch (builtin) {
+  case Builtin::Add:
+    return Value::number(add(params));
+  case Builtin::And:
+    return Value::boolean(andfunc(params));
+  case Builtin::Compare:
+    return Value::number(comparison(params));
+  case Builtin::Cons:
+    return cons(params);
+  case Builtin::Div:
+    return Value::number(div(params));
+  case Builtin::Eq:
+    return Value::boolean(comparison(params) == 0);
+  case Builtin::Filter:
+    return filter(params);
+  case Builtin::Flush:
+    flush();
+    return Value();
+  case Builtin::Foldr:
+    return foldr(params);
+  case Builtin::Ge:
+    return Value::boolean(comparison(params) >= 0);
+  case Builtin::Gt:
+    return Value::boolean(comparison(params) > 0);
+  case Builtin::Head:
+    return head(params);
+  case Builtin::Le:
+    return Value::boolean(comparison(params) <= 0);
+  case Builtin::Load:
+    load(params);
+    return Value();
+  case Builtin::Lt:
+    return Value::boolean(comparison(params) < 0);
+  case Builtin::Map:
+    return map(params);
+  case Builtin::Memstats:
+    return memstats(params);
+  case Builtin::Mul:
+    return Value::number(mul(params));
+  case Builtin::Nand:
+    return Value::boolean(nandfunc(params));
+  case Builtin::Ne:
+    return Value::boolean(comparison(params) != 0);
+  case Builtin::Nor:
+    return Value::boolean(norfunc(params));
+  case Builtin::Not:
+    return Value::boolean(notfunc(params));
+  case Builtin::Null:
+    return Value::boolean(isNull(params));
+  case Builtin::Or:
+    return Value::boolean(orfunc(params));
+  case Builtin::Print:
+    print(params);
+    return Value();
+  case Builtin::Pmap:
+    return pmap(params);
+  case Builtin::Preduce:
+    return preduce(params);
+  case Builtin::Println:
+    println(params);
+    return Value();
+  case Builtin::Quit:
+    quit(params);
+    return Value();
+  case Builtin::Reduce:
+    return reduce(params);
+  case Builtin::Sub:
+    return Value::number(sub(params));
+  case Builtin::Tail:
+    return tail(params);
+  case Builtin::Xnor:
+    return Value::boolean(xnorfunc(params));
+  case Builtin::Xor:
+    return Value::boolean(xorfunc(params));
+  default:
+    break;
+  }
+  throw Exception("Fatal implementation error in evalBuiltIns. The standard "
+                  "library is flawed.");
 }
 
-std::string Interpreter::removeparens(const std::string &original) const {
-  if (isParens(original)) {
-    return original.substr(1, original.length() - 2);
-  } else {
-    return original;
+/**
+ * printcode- a function that prints the code, really just for debugging
+ */
+void Interpreter::printcode() {
+  for (const Node &statement : code) {
+    *options.output << statement.text << "\n";
   }
 }
 
-std::string Interpreter::removelist(const std::string &original) const {
-  if (isList(original)) {
-    return original.substr(1, original.length() - 2);
-  } else {
-    return original;
-  }
+/**
+ * isList function
+ * @param val the value you are testing to be a list
+ * @return if the thing passed is a list or the text of one
+ */
+bool Interpreter::isList(const Value &val) const {
+  return val.isList() ||
+         (val.isString() && parser.isListText(val.asString()));
 }
 
-bool Interpreter::isNumber(const std::string &value) const {
-  if (memory.numexists(value)) {
-    return true;
-  }
-  if (value.length() == 0) {
-    return false;
-  }
-  if (value[0] == '-' || isdigit(value[0])) {
-    for (uint32_t x = 0; x < value.length(); x++) {
-      if (!isdigit(value[x])) {
-        return false;
-      }
-    }
-    return true;
-  } else {
-    return false;
+/**
+ * toList
+ * @param val you want to convert
+ * @return the list held by the value, list text is parsed
+ */
+Value Interpreter::toList(const Value &val) const {
+  if (val.isList()) {
+    return val;
+  } else if (!isList(val)) {
+    throw Exception("Expected a list but got \"" + val.str() + "\"");
   }
+  return parser.parseList(val.asString()).value;
 }
 
-bool Interpreter::isBoolean(const std::string &value) const {
-  if (memory.boolexists(value)) {
-    return true;
+/**
+ * toInt
+ * @param val you want to convert
+ * @return an integer evaluated from the number, only used in quit
+ */
+int Interpreter::toInt(const Value &val) const { return toNumber(val).truncate(); }
+
+/**
+ * toNumber
+ * @param val you want to convert
+ * @return the num held by the value, numeric text is parsed
+ */
+num Interpreter::toNumber(const Value &val) const {
+  if (val.isNumber()) {
+    return val.asNumber();
+  } else if (!isNumber(val)) {
+    throw Exception("Variable " + val.str() + " does not exist");
   }
-  return (value == "true" || value == "false" || value == "0" || value == "1");
+  return num::parse(val.str());
 }
 
-std::string Interpreter::normalizenumber(num x) const {
-  if (fmod(x, 1) < .000001) {
-    return std::to_string(((int)x));
-  } else {
-    std::stringstream ss;
-    ss << x;
-    return ss.str();
+/**
+ * toBoolean
+ * @param val you want to convert
+ * @return the boolean held by the value
+ */
+bool Interpreter::toBoolean(const Value &val) const {
+  if (val.isBoolean()) {
+    return val.asBoolean();
+  }
+  if (!isBoolean(val)) {
+    *options.errors << "Calling strtobool on nonboolean value \""
+                    << val.str() << "\"" << std::endl;
   }
+  const std::string text = val.str();
+  return (text == "true" || text == "1");
 }
 
-std::string Interpreter::normalizebool(bool x) const {
-  return x ? "true" : "false";
+bool Interpreter::isNumber(const Value &value) const {
+  return value.isNumber() ||
+         (value.isString() && Value::isNumeric(value.asString()));
+}
+
+bool Interpreter::isBoolean(const Value &value) const {
+  if (value.isBoolean()) {
+    return true;
+  } else if (value.isList() || value.isFunction() || value.isNone()) {
+    return false;
+  }
+  const std::string text = value.str();
+  return (text == "true" || text == "false" || text == "0" || text == "1");
 }
 
 std::vector<bool>
-Interpreter::parameterstobool(const std::vector<std::string> &vals) {
+Interpreter::parameterstobool(const std::vector<Value> &vals) {
   std::vector<bool> parameters;
-  std::transform(vals.begin() + 1, vals.end(), std::back_inserter(parameters),
-                 [&](std::string in) -> bool {
-                   if (isParens(in)) {
-                     return strtobool(eval(in));
-                   } else {
-                     if (!isBoolean(in)) {
-                       return memory.getboolean(in);
-                     } else {
-                       return strtobool(in);
-                     }
-                   }
-                 });
+  std::transform(vals.begin(), vals.end(), std::back_inserter(parameters),
+                 [&](const Value &in) -> bool { return toBoolean(in); });
   return parameters;
 }
 
 std::vector<num>
-Interpreter::parameterstonums(const std::vector<std::string> &vals) {
+Interpreter::parameterstonums(const std::vector<Value> &vals) {
   std::vector<num> parameters;
-  std::transform(vals.begin() + 1, vals.end(), std::back_inserter(parameters),
-                 [&](std::string in) -> num {
-                   if (isParens(in)) {
-                     return strToNum(eval(in));
-                   } else {
-                     if (!isNumber(in)) {
-                       return memory.getnum(in);
-                     } else {
-                       return strToNum(in);
-                     }
-                   }
-                 });
+  std::transform(vals.begin(), vals.end(), std::back_inserter(parameters),
+                 [&](const Value &in) -> num { return toNumber(in); });
   return parameters;
 }
 
-std::vector<std::string>
-Interpreter::evalParameters(const std::vector<std::string> &vals) {
-  std::vector<std::string> parameters;
-  std::transform(vals.begin() + 1, vals.end(), std::back_inserter(parameters),
-                 [&](std::string in) -> std::string {
-                   if (isParens(in)) {
-                     return eval(in);
-                   } else {
-                     if (memory.varexists(in)) {
-                       return memory.get(in);
-                     } else if (isString(in)) {
-                       return removequotes(in);
-                     } else {
-                       return in;
-                     }
-                   }
-                 });
+/**
+ * evalArgument
+ * @param argument a word of an expression
+ * @return the value of the argument, variables are looked up and nested
+ * expressions are evaluated
+ */
+Value Interpreter::evalArgument(const Node &argument) {
+  switch (argument.type) {
+  case NodeType::Expression:
+  case NodeType::Definition:
+    return eval(argument);
+  case NodeType::Literal:
+    return argument.value;
+  case NodeType::List:
+    return argument.value;
+  case NodeType::Word:
+    return lookup(argument.symbol, argument.slot);
+  }
+  return Value();
+}
+
+/**
+ * lookup
+ * @param symbol a bare word
+ * @param slot the frame slot of the word if it is a variable of the running
+ * function
+ * @return the value of the variable named word, the function named word, or
+ * else the word itself as a string
+ */
+Value Interpreter::lookup(Symbol symbol, uint32_t slot) const {
+  const Value *variable =
+      slot != NO_SLOT ? memory.getslot(slot) : memory.find(symbol);
+  if (variable != nullptr) {
+    return *variable;
+  }
+  const std::string &word = memory.symboltable()->name(symbol);
+  if (memory.functioninuse(word)) {
+    return Value::function(word);
+  }
+  return Value::string(word);
+}
+
+/**
+ * symbolOf
+ * @param word the name in a declaration
+ * @return the symbol of the name
+ */
+Symbol Interpreter::symbolOf(const Node &word) const {
+  return word.type == NodeType::Word ? word.symbol
+                                     : memory.symboltable()->intern(word.text);
+}
+
+std::vector<Value> Interpreter::evalParameters(const Node &expression) {
+  std::vector<Value> parameters;
+  std::transform(expression.children.begin() + 1, expression.children.end(),
+                 std::back_inserter(parameters),
+                 [&](const Node &in) -> Value { return evalArgument(in); });
   return parameters;
 }
 
-void Interpreter::print(const std::vector<std::string> &words) {
-  if (words.size() < 2) {
-    std::cout << std::endl;
-  } else {
-    std::vector<std::string> params = evalParameters(words);
-    for (uint32_t j = 0; j < params.size(); ++j) {
-      if (params[j] == "~") {
-        std::cout << std::endl;
-      } else {
-        std::cout << params[j] << std::flush;
-      }
-    }
+void Interpreter::print(const std::vector<Value> &params) {
+  std::lock_guard<std::mutex> guard(*printing);
+  write(params);
+  if (options.unbuffered) {
+    *options.output << std::flush;
   }
 }
 
-void Interpreter::println(const std::vector<std::string> &words) {
-  if (words.size() < 2) {
-    std::cout << std::endl;
-  } else {
-    std::vector<std::string> params = evalParameters(words);
-    for (uint32_t j = 0; j < params.size(); ++j) {
-      if (params[j] == "~") {
-        std::cout << std::endl;
-      } else {
-        std::cout << params[j] << std::flush;
-      }
-    }
+void Interpreter::println(const std::vector<Value> &params) {
+  std::lock_guard<std::mutex> guard(*printing);
+  write(params);
+  *options.output << '\n';
+  if (options.unbuffered) {
+    *options.output << std::flush;
   }
-  std::cout << std::endl;
 }
 
-void Interpreter::quit(const std::vector<std::string> &words) {
-  if (words.size() == 1) {
-    exit(EXIT_SUCCESS);
-  } else {
-    if (isParens(words[1])) {
-      exit(strToInt(eval(words[1])));
+/**
+ * write- the output of print, after the results each has not written yet,
+ * the caller holds the printing lock
+ * @param params the values to print
+ */
+void Interpreter::write(const std::vector<Value> &params) {
+  std::ostream &out = *options.output;
+  if (!pending.empty()) {
+    out.write(pending.data(), pending.size());
+    pending.clear();
+  }
+  if (params.empty()) {
+    out << '\n';
+  }
+  for (const Value &param : params) {
+    if (param.isString() && param.asString() == "~") {
+      out << '\n';
     } else {
-      exit(strToInt(words[1]));
+      out << param.str();
     }
   }
 }
 
-void Interpreter::declarestring(const std::vector<std::string> &vals) {
+/**
+ * flush- writes out what was printed so far, printing is buffered unless
+ * the interpreter runs unbuffered
+ */
+void Interpreter::flush() {
+  std::lock_guard<std::mutex> guard(*printing);
+  options.output->write(pending.data(), pending.size());
+  pending.clear();
+  *options.output << std::flush;
+}
+
+void Interpreter::quit(const std::vector<Value> &params) {
+  throw Quit(params.empty() ? EXIT_SUCCESS : toInt(params[0]));
+}
+
+void Interpreter::declarestring(const Node &expression) {
+  const std::vector<Node> &vals = expression.children;
   if (vals.size() != 3) {
     throw Exception("Wrong number of parameters for string initialization");
   }
-  if (isParens(vals[2])) {
-    memory.createstring(vals[1], eval(vals[2]));
-  } else {
-    memory.createstring(vals[1], removequotes(vals[2]));
-  }
+  declare("string", symbolOf(vals[1]), evalArgument(vals[2]));
 }
 
-void Interpreter::declareboolean(const std::vector<std::string> &vals) {
+void Interpreter::declareboolean(const Node &expression) {
+  const std::vector<Node> &vals = expression.children;
   if (vals.size() != 3) {
     throw Exception("Wrong number of parameters for boolean initialization");
   }
-  bool a;
-  if (isParens(vals[2])) {
-    std::string temp = eval(vals[2]);
-    a = (temp == "true" || temp == "t" || temp == "1") ? true : false;
-  } else {
-    a = (vals[2] == "true" || vals[2] == "t" || vals[2] == "1") ? true : false;
-  }
-  memory.createboolean(vals[1], a);
+  declare("boolean", symbolOf(vals[1]), evalArgument(vals[2]));
 }
 
-void Interpreter::declarenum(const std::vector<std::string> &vals) {
+void Interpreter::declarenum(const Node &expression) {
+  const std::vector<Node> &vals = expression.children;
   if (vals.size() != 3) {
     throw Exception("Wrong number of parameters for num initialization");
   }
-  if (isParens(vals[2])) {
-    memory.createnum(vals[1], strToNum(eval(vals[2])));
-  } else {
-    memory.createnum(vals[1], strToNum(vals[2]));
-  }
+  declare("num", symbolOf(vals[1]), evalArgument(vals[2]));
 }
 
-void Interpreter::declarelist(const std::vector<std::string> &vals) {
+void Interpreter::declarelist(const Node &expression) {
+  const std::vector<Node> &vals = expression.children;
   if (vals.size() != 3) {
     throw Exception("Wrong number of parameters for list initialization");
   }
-  if (isParens(vals[2])) {
-    memory.createlist(vals[1], strtolist(eval(vals[2])));
+  declare("list", symbolOf(vals[1]), evalArgument(vals[2]));
+}
+
+/**
+ * declare- creates a variable in the current scope
+ * @param type one of string, boolean, num or list
+ * @param name the name of the variable
+ * @param value the evaluated value
+ */
+void Interpreter::declare(const std::string &type, Symbol name,
+                          const Value &value) {
+  if (type == "string") {
+    memory.create(name,
+                  value.isString() ? value : Value::string(value.str()));
+  } else if (type == "boolean") {
+    const std::string text = value.str();
+    memory.create(name, Value::boolean(text == "true" || text == "t" ||
+                                       text == "1"));
+  } else if (type == "num") {
+    memory.create(name, Value::number(toNumber(value)));
+  } else if (type == "list") {
+    memory.create(name, toList(value));
   } else {
-    memory.createlist(vals[1], strtolist(vals[2]));
+    throw Exception("Type " + type + " does not exist");
   }
 }
 
-std::string Interpreter::read(const std::vector<std::string> &vals) {
+Value Interpreter::read(const Node &expression) {
+  const std::vector<Node> &vals = expression.children;
   if (vals.size() > 2) {
     throw Exception("Wrong number of parameters for reading");
   }
+  flush();
   std::string input;
-  std::cin >> input;
+  *options.input >> input;
   if (vals.size() == 2) {
-    memory.createstring(vals[1], input);
+    memory.create(vals[1].text, Value::string(input));
   }
-  return input;
+  return Value::string(input);
 }
 
-std::string Interpreter::ifstatement(const std::vector<std::string> &vals) {
+Value Interpreter::ifstatement(const Node &expression) {
+  return evalArgument(branch(expression));
+}
+
+/**
+ * branch
+ * @param expression an if statement
+ * @return the branch its condition selects, not yet evaluated
+ */
+const Node &Interpreter::branch(const Node &expression) {
+  const std::vector<Node> &vals = expression.children;
   if (vals.size() != 4) {
     throw Exception("Wrong number of inputs for if statement");
   }
-  bool expr;
-  if (isParens(vals[1])) {
-    expr = strtobool(eval(vals[1]));
-  } else {
-    if (!isBoolean(vals[1])) {
-      throw Exception("First value must be a boolean value in if statement");
-    }
-    expr = strtobool(vals[1]);
-  }
-  uint8_t index = expr ? 2 : 3;
-  if (isParens(vals[index])) {
-    return eval(vals[index]);
-  } else if (memory.varexists(vals[index])) {
-    return memory.get(vals[index]);
-  } else {
-    return vals[index];
+  Value condition = evalArgument(vals[1]);
+  if (!isBoolean(condition)) {
+    throw Exception("First value must be a boolean value in if statement");
   }
+  uint8_t index = toBoolean(condition) ? 2 : 3;
+  return vals[index];
 }
 
-void Interpreter::define(const std::vector<std::string> &vals) {
-  std::vector<std::string> definition = split(vals[0]);
-  if (definition.size() < 3 || definition.size() % 2 == 0) {
-    throw Exception("Cannot define function \"" + definition[2] +
-                    "\" due to wrong number of parameters");
+void Interpreter::define(const Function &function) {
+  memory.createfunction(function.name, compile(function));
+}
+
+/**
+ * compile
+ * @param function a parsed function
+ * @return the function with its frame layout resolved, and its bytecode
+ * attached when running on the vm. It is shared by every call and never
+ * copied again.
+ */
+std::shared_ptr<const Function>
+Interpreter::compile(const Function &function) const {
+  auto compiled = std::make_shared<Function>(function);
+  if (compiled->kind != FunctionKind::Subroutine) {
+    compiler.resolve(*compiled);
+  }
+  if (options.engine == Engine::VM) {
+    compiled->bytecode =
+        std::make_shared<const Chunk>(compiler.compile(*compiled));
   }
-  memory.createfunction(definition[2], vals);
+  return compiled;
 }
 
-std::string Interpreter::call(const std::vector<std::string> &vals) {
-  std::string returnval = "";
-  std::string functionname = vals[0];
-  std::vector<std::string> fncode = memory.getfn(functionname);
-  std::vector<std::string> definition = split(fncode[0]);
-  double numberOfParameters = (definition.size() - 3) / 2.0;
-  if (vals.size() - 1 != (numberOfParameters)) {
+Value Interpreter::call(const std::string &name,
+                        const std::vector<Value> &params) {
+  const Function &fncode = memory.getfn(name);
+  if (params.size() != fncode.parameters.size()) {
     throw Exception("Wrong number of parameters for call to function " +
-                    vals[0]);
+                    name);
   }
-  auto params = evalParameters(vals);
-  memory.enterfn(params, definition);
-  std::string returnname = "return";
-  for (auto curr = fncode.begin() + 1; curr != fncode.end(); ++curr) {
+  CallScope scope(*this, fncode.name);
+  scope.enter(fncode, params);
+  return execute(fncode);
+}
 
-    if ((*curr).substr(0, returnname.length()) == "return") {
-      std::vector<std::string> words = split(*curr);
-      if (isParens(words[1])) {
-        returnval = eval(words[1]);
-      } else {
-        returnval = words[1];
-      }
-      break;
-    } else {
-      eval(*curr);
+/**
+ * CallScope constructor- enters the profile entry of a call
+ * @param interpreter the interpreter making the call
+ * @param name the function or builtin called
+ */
+Interpreter::CallScope::CallScope(Interpreter &interpreter,
+                                  std::string_view name)
+    : interpreter(&interpreter) {
+  if (interpreter.profiler) {
+    interpreter.profiler->enter(name);
+  }
+}
+
+Interpreter::CallScope::~CallScope() {
+  if (interpreter == nullptr) {
+    return;
+  }
+  if (entered) {
+    interpreter->memory.leavefn();
+  }
+  if (interpreter->profiler) {
+    interpreter->profiler->leave();
+  }
+}
+
+/**
+ * enter- enters the memory frame of the call
+ * @param function the function called
+ * @param args its parameters
+ */
+void Interpreter::CallScope::enter(const Function &function,
+                                   const std::vector<Value> &args) {
+  interpreter->memory.enterfn(args, function);
+  entered = true;
+}
+
+/**
+ * release- hands the frame and profile entry over to the vm, which leaves
+ * them when the call returns or unwinds
+ */
+void Interpreter::CallScope::release() { interpreter = nullptr; }
+
+/**
+ * execute- runs a function body on the selected engine
+ * @param function the function, its frame must already be entered
+ * @return the value of the return statement
+ */
+Value Interpreter::execute(const Function &function) {
+  // the vm keeps its calls off the native stack, the tree walker and calls
+  // made from code the vm leaves to it do not
+  char marker;
+  const uintptr_t here = reinterpret_cast<uintptr_t>(&marker);
+  const size_t used =
+      here < stackstart ? stackstart - here : here - stackstart;
+  if (used > options.nativeStack) {
+    throw Exception("Calls to " + function.name +
+                    " are nested too deeply for the tree engine, try "
+                    "--engine=vm");
+  }
+  if (function.bytecode) {
+    return vm.run(*function.bytecode);
+  }
+  Value returnval = run(function);
+  while (tailcall.function != nullptr) {
+    const Function &next = *tailcall.function;
+    std::vector<Value> params = std::move(tailcall.params);
+    tailcall.function = nullptr;
+    memory.replacefn(params, next);
+    if (profiler) {
+      profiler->leave();
+      profiler->enter(next.name);
     }
+    returnval = run(next);
   }
-  memory.leavefn();
   return returnval;
 }
 
-void Interpreter::subroutine(const std::vector<std::string> &vals) {
-  std::vector<std::string> definition = split(vals[0]);
-  if (definition.size() != 2) {
-    throw Exception("Cannot define subroutine \"" + definition[1] +
-                    "\" due to parameters trying to be defined");
+/**
+ * run- evaluates the body of a function until it returns
+ * @param function the function, its frame must already be entered
+ * @return the value of the return statement
+ */
+Value Interpreter::run(const Function &function) {
+  const std::string returnname = "return";
+  for (const Node &statement : function.body) {
+    const Node &command = statement.children[0];
+    if (command.type == NodeType::Word && command.text == returnname) {
+      return statement.children.size() > 1
+                 ? evalTail(statement.children[1])
+                 : Value();
+    }
+    eval(statement);
+  }
+  return Value();
+}
+
+/**
+ * evalTail- evaluates the value a function returns, a call it ends in is not
+ * made but left in tailcall for execute to run in the same frame
+ * @param argument the argument of the return statement
+ * @return its value, nothing if a tail call was left
+ */
+Value Interpreter::evalTail(const Node &argument) {
+  if (argument.type != NodeType::Expression || argument.children.empty()) {
+    return evalArgument(argument);
+  }
+  const std::vector<Node> &words = argument.children;
+  if (words[0].type == NodeType::Expression) {
+    return evalTail(words[0]);
+  } else if (words[0].builtin == Builtin::If) {
+    return evalTail(branch(argument));
+  }
+  const Function *callee = words[0].type == NodeType::Word &&
+                                   words[0].builtin == Builtin::None
+                               ? callable(words[0].text)
+                               : nullptr;
+  if (callee == nullptr || callee->kind != FunctionKind::Function) {
+    return evalArgument(argument);
+  }
+  std::vector<Value> params = evalParameters(argument);
+  if (params.size() != callee->parameters.size()) {
+    throw Exception("Wrong number of parameters for call to function " +
+                    words[0].text);
   }
-  memory.createsub(definition[1], vals);
+  tailcall.function = callee;
+  tailcall.params = std::move(params);
+  return Value();
 }
 
-std::string Interpreter::callsubroutine(const std::string &name) {
-  std::vector<std::string> subr = memory.getfn(name);
-  std::for_each(subr.begin() + 1, subr.end(),
-                [&](std::string line) -> void { eval(line); });
-  return "";
+void Interpreter::subroutine(const Function &function) {
+  memory.createsub(function.name, compile(function));
 }
 
-void Interpreter::defmem(const std::vector<std::string> &vals) {
-  std::vector<std::string> definition = split(vals[0]);
-  if (definition.size() < 3 || definition.size() % 2 == 0) {
-    throw Exception("Cannot define function \"" + definition[2] +
-                    "\" due to wrong number of parameters");
+Value Interpreter::callsubroutine(const std::string &name) {
+  const Function &subr = memory.getfn(name);
+  CallScope scope(*this, subr.name);
+  // subroutines run in the frame of their caller, so they are traced here
+  const uint64_t start = tracer ? tracer->now() : 0;
+  if (subr.bytecode) {
+    vm.run(*subr.bytecode);
+  } else {
+    std::for_each(subr.body.begin(), subr.body.end(),
+                  [&](const Node &line) -> void { eval(line); });
   }
-  memory.createmem(definition[2], vals);
+  if (tracer) {
+    tracer->span(subr.name, "subroutine", start);
+  }
+  return Value();
 }
 
-std::string Interpreter::callmem(const std::vector<std::string> &vals) {
-  std::string returnval = "";
-  std::string functionname = vals[0];
-  std::vector<std::string> fncode = memory.getfn(functionname);
-  std::vector<std::string> definition = split(fncode[0]);
-  double numberOfParameters = (definition.size() - 3) / 2.0;
-  if (vals.size() - 1 != (numberOfParameters)) {
+void Interpreter::defmem(const Function &function) {
+  memory.createmem(function.name, compile(function));
+}
+
+Value Interpreter::callmem(const std::string &name,
+                           const std::vector<Value> &params) {
+  const Function &fncode = memory.getfn(name);
+  if (params.size() != fncode.parameters.size()) {
     throw Exception("Wrong number of parameters for call to function " +
-                    vals[0]);
+                    name);
+  }
+  CallScope scope(*this, fncode.name);
+  Value returnval;
+  if (!memory.checkmem(name, params, returnval)) {
+    try {
+      scope.enter(fncode, params);
+      returnval = execute(fncode);
+    } catch (...) {
+      memory.abandonmem(name, params);
+      throw;
+    }
+    memory.insertmem(name, params, returnval);
   }
-  auto params = evalParameters(vals);
-  std::string *check = memory.checkmem(functionname, params);
-  if (check != nullptr) {
-    return *check;
+  return returnval;
+}
+
+/**
+ * memstats- reads the counters of the memo table
+ * @param vals optionally the defmem function to read, else all of them
+ * @return [hits misses evictions entries bytes]
+ */
+Value Interpreter::memstats(const std::vector<Value> &vals) {
+  if (vals.size() > 1) {
+    throw Exception("Wrong number of parameters for memstats");
   }
-  memory.enterfn(params, definition);
-  std::string returnname = "return";
-  for (auto curr = fncode.begin() + 1; curr != fncode.end(); ++curr) {
+  MemoStats stats =
+      vals.empty() ? memory.memstats() : memory.memstats(vals[0].str());
+  return Value::listOf({Value::number(int64_t(stats.hits)),
+                        Value::number(int64_t(stats.misses)),
+                        Value::number(int64_t(stats.evictions)),
+                        Value::number(int64_t(stats.entries)),
+                        Value::number(int64_t(stats.bytes))});
+}
 
-    if ((*curr).substr(0, returnname.length()) == returnname) {
-      std::vector<std::string> words = split(*curr);
-      if (isParens(words[1])) {
-        returnval = eval(words[1]);
-      } else {
-        returnval = words[1];
-      }
-      break;
-    } else {
-      eval(*curr);
+void Interpreter::printmemstats() const {
+  auto print = [&](const std::string &name, const MemoStats &stats) {
+    *options.errors << "memo " << name << ": " << stats.hits << " hits, "
+                    << stats.misses << " misses, " << stats.evictions
+                    << " evictions, " << stats.entries << " entries, "
+                    << stats.bytes << " bytes" << std::endl;
+  };
+  for (const std::string &name : memory.memfunctions()) {
+    print(name, memory.memstats(name));
+  }
+  print("total", memory.memstats());
+}
+
+/**
+ * printprofile- prints the calls and time of every function and builtin to
+ * stderr, the most time spent in the function itself first
+ */
+void Interpreter::printprofile() {
+  profiler->stop();
+  auto ms = [](std::chrono::nanoseconds time) { return time.count() / 1e6; };
+  std::ostream &errors = *options.errors;
+  errors << std::fixed << std::setprecision(3);
+  for (const ProfileEntry &entry : profiler->results()) {
+    errors << "profile " << entry.name << ": " << entry.calls << " calls, "
+           << ms(entry.inclusive) << " ms inclusive, " << ms(entry.exclusive)
+           << " ms exclusive";
+    if (memory.isMem(entry.name)) {
+      const MemoStats stats = memory.memstats(entry.name);
+      const uint64_t lookups = stats.hits + stats.misses;
+      errors << ", " << (lookups != 0 ? 100.0 * stats.hits / lookups : 0)
+             << "% memo hits";
     }
+    errors << std::endl;
   }
-  memory.leavefn();
-  memory.insertmem(functionname, params, returnval);
-  return returnval;
+  errors.unsetf(std::ios::floatfield);
+  errors << std::setprecision(6);
 }
 
 /**
- * load the file given as parameter vals[1]
+ * load the file given as parameter vals[0]
+ * A file is only run once, loading it again does nothing, so files loaded
+ * by several others are not defined twice. A file that fails counts as not
+ * loaded.
  * @param vals
  */
-void Interpreter::load(const std::vector<std::string> &vals) {
-  if (vals.size() != 2) {
+void Interpreter::load(const std::vector<Value> &vals) {
+  if (vals.size() != 1) {
     throw Exception("Must have one parameter for load");
   }
-  const std::string filename =
-      (isString(vals[1]) ? removequotes(vals[1]) : strtostr(vals[1]));
-  std::vector<std::string> loadedcode = loadCodeFromFile(filename);
-  std::for_each(loadedcode.begin(), loadedcode.end(),
-                [&](std::string line) -> void { eval(line); });
+  std::error_code error;
+  std::string path =
+      std::filesystem::weakly_canonical(vals[0].str(), error).string();
+  if (error) {
+    path = vals[0].str();
+  }
+  if (loaded.count(path) != 0) {
+    return;
+  }
+  const uint64_t start = tracer ? tracer->now() : 0;
+  std::vector<Node> loadedcode = loadCodeFromFile(vals[0].str());
+  // marked before it runs so files that load each other stop, and unmarked
+  // again if it fails so it can be loaded once fixed
+  loaded.insert(path);
+  try {
+    std::for_each(loadedcode.begin(), loadedcode.end(),
+                  [&](const Node &line) -> void { eval(line); });
+  } catch (...) {
+    loaded.erase(path);
+    throw;
+  }
+  if (tracer) {
+    tracer->span(tracer->keep(vals[0].str()), "load", start);
+  }
 }
 
-num Interpreter::add(const std::vector<std::string> &vals) {
-  if (vals.size() < 2) {
+num Interpreter::add(const std::vector<Value> &vals) {
+  if (vals.size() < 1) {
     throw Exception("Too few inputs for add");
   }
   std::vector<num> parameters = parameterstonums(vals);
   return std::accumulate(parameters.begin(), parameters.end(), num(0));
 }
 
-num Interpreter::sub(const std::vector<std::string> &vals) {
-  if (vals.size() < 2) {
+num Interpreter::sub(const std::vector<Value> &vals) {
+  if (vals.size() < 1) {
     throw Exception("Too few inputs for sub");
   }
   std::vector<num> parameters = parameterstonums(vals);
@@ -937,8 +1255,8 @@ num Interpreter::sub(const std::vector<std::string> &vals) {
                                          parameters.end(), num(0), std::minus<>{});
 }
 
-num Interpreter::mul(const std::vector<std::string> &vals) {
-  if (vals.size() < 2) {
+num Interpreter::mul(const std::vector<Value> &vals) {
+  if (vals.size() < 1) {
     throw Exception("Too few inputs for mul");
   }
   std::vector<num> parameters = parameterstonums(vals);
@@ -946,8 +1264,8 @@ num Interpreter::mul(const std::vector<std::string> &vals) {
                          std::multiplies<>{});
 }
 
-num Interpreter::div(const std::vector<std::string> &vals) {
-  if (vals.size() < 2) {
+num Interpreter::div(const std::vector<Value> &vals) {
+  if (vals.size() < 1) {
     throw Exception("Too few inputs for div");
   }
   std::vector<num> parameters = parameterstonums(vals);
@@ -962,7 +1280,7 @@ num Interpreter::div(const std::vector<std::string> &vals) {
   return curr;
 }
 
-bool Interpreter::andfunc(const std::vector<std::string> &vals) {
+bool Interpreter::andfunc(const std::vector<Value> &vals) {
   std::vector<bool> params = parameterstobool(vals);
   if (params.size() < 2) {
     throw Exception("and function has too few parameters");
@@ -975,7 +1293,7 @@ bool Interpreter::andfunc(const std::vector<std::string> &vals) {
   return true;
 }
 
-bool Interpreter::orfunc(const std::vector<std::string> &vals) {
+bool Interpreter::orfunc(const std::vector<Value> &vals) {
   std::vector<bool> params = parameterstobool(vals);
   if (params.size() < 2) {
     throw Exception("or function has too few parameters");
@@ -988,28 +1306,28 @@ bool Interpreter::orfunc(const std::vector<std::string> &vals) {
   return false;
 }
 
-bool Interpreter::notfunc(const std::vector<std::string> &vals) {
-  if (vals.size() != 2) {
+bool Interpreter::notfunc(const std::vector<Value> &vals) {
+  if (vals.size() != 1) {
     throw Exception("Not function can only take one parameter");
   }
-  return !(strtobool(vals[1]));
+  return !(toBoolean(vals[0]));
 }
 
-bool Interpreter::nandfunc(const std::vector<std::string> &vals) {
-  if (vals.size() < 3) {
+bool Interpreter::nandfunc(const std::vector<Value> &vals) {
+  if (vals.size() < 2) {
     throw Exception("nand function has too few parameters");
   }
   return !andfunc(vals);
 }
 
-bool Interpreter::norfunc(const std::vector<std::string> &vals) {
-  if (vals.size() < 3) {
+bool Interpreter::norfunc(const std::vector<Value> &vals) {
+  if (vals.size() < 2) {
     throw Exception("nor function has too few parameters");
   }
   return !orfunc(vals);
 }
 
-bool Interpreter::xorfunc(const std::vector<std::string> &vals) {
+bool Interpreter::xorfunc(const std::vector<Value> &vals) {
   std::vector<bool> params = parameterstobool(vals);
   if (params.size() != 2) {
     throw Exception("xor function must have two parameters");
@@ -1017,50 +1335,47 @@ bool Interpreter::xorfunc(const std::vector<std::string> &vals) {
   return (params[0] != params[1]);
 }
 
-bool Interpreter::xnorfunc(const std::vector<std::string> &vals) {
-  if (vals.size() != 3) {
+bool Interpreter::xnorfunc(const std::vector<Value> &vals) {
+  if (vals.size() != 2) {
     throw Exception("xnor function must have two parameters");
   }
   return !xorfunc(vals);
 }
 
-int Interpreter::comparison(const std::vector<std::string> &vals) {
+int Interpreter::comparison(const std::vector<Value> &vals) {
   // return 0 if eq, 1 if greater than, -1 if less than
-  if (vals.size() != 3) {
+  if (vals.size() != 2) {
     throw Exception("Comparision can only be between two values");
   }
-  std::string vals1 = isParens(vals[1]) ? eval(vals[1]) : vals[1];
-  std::string vals2 = isParens(vals[2]) ? eval(vals[2]) : vals[2];
+  const Value &vals1 = vals[0];
+  const Value &vals2 = vals[1];
 
-  if (isBoolean(vals1) && isBoolean(vals2)) {
-    bool a, b;
-    a = strtobool(vals1);
-    b = strtobool(vals2);
-    if (a == b) {
+  if (isNumber(vals1) && isNumber(vals2)) {
+    num x, y;
+    x = toNumber(vals1);
+    y = toNumber(vals2);
+    if (x == y) {
       return 0;
-    } else if (a && !b) {
+    } else if (x > y) {
       return 1;
     } else {
       return -1;
     }
   }
-  if (isNumber(vals1) && isNumber(vals2)) {
-    num x, y;
-    x = strToNum(vals1);
-    y = strToNum(vals2);
-    if (x == y) {
+  if (isBoolean(vals1) && isBoolean(vals2)) {
+    bool a, b;
+    a = toBoolean(vals1);
+    b = toBoolean(vals2);
+    if (a == b) {
       return 0;
-    } else if (x > y) {
+    } else if (a && !b) {
       return 1;
     } else {
       return -1;
     }
   }
-  if (isString(vals1) && isString(vals2)) {
-    std::string a, b;
-    a = strtostr(vals1);
-    b = strtostr(vals2);
-    int returnval = a.compare(b);
+  if (vals1.type() == vals2.type() && !vals1.isNone()) {
+    int returnval = vals1.str().compare(vals2.str());
     if (returnval == 0) {
       return 0;
     } else {
@@ -1075,96 +1390,362 @@ int Interpreter::comparison(const std::vector<std::string> &vals) {
   return 0;
 }
 
-std::string Interpreter::head(const std::vector<std::string> &vals) {
-  if (vals.size() != 2) {
+Value Interpreter::head(const std::vector<Value> &vals) {
+  if (vals.size() != 1) {
     throw Exception("Wrong number of parameters for head");
+  } else if (!isList(vals[0])) {
+    throw Exception("Head called on a non list");
+  }
+  Value list = toList(vals[0]);
+  const Cell *first = list.asList().get();
+  if (first == nullptr) {
+    return Value();
   }
-  std::string headval =
-      isParens(vals[1]) ? getHead(eval(vals[1])) : getHead(vals[1]);
-  return (isParens(headval)) ? eval(headval) : headval;
+  return element(*first);
 }
 
-std::string Interpreter::getHead(const std::string &val) const {
-  if (!isList(val) && !memory.listexists(val)) {
-    throw Exception("Head called on a non list");
-  } else {
-    return listSplit(strtolist(val)).first;
+Value Interpreter::tail(const std::vector<Value> &vals) {
+  if (vals.size() != 1) {
+    throw Exception("Wrong number of parameters for tail");
+  } else if (!isList(vals[0])) {
+    throw Exception("Tail called on a non list");
+  }
+  Value list = toList(vals[0]);
+  if (!list.asList()) {
+    throw Exception("Tail called on null list");
   }
+  return Value::list(list.asList()->tail);
 }
 
-std::string Interpreter::tail(const std::vector<std::string> &vals) {
+Value Interpreter::cons(const std::vector<Value> &vals) {
   if (vals.size() != 2) {
-    throw Exception("Wrong number of parameters for tail");
+    throw Exception("Wrong number of parameters for cons");
   }
-  if (isParens(vals[1])) {
-    return getTail(eval(vals[1]));
-  } else {
-    return getTail(vals[1]);
+  auto cell = std::make_shared<Cell>();
+  cell->head = vals[0];
+  cell->tail = toList(vals[1]).asList();
+  return Value::list(std::move(cell));
+}
+
+bool Interpreter::isNull(const std::vector<Value> &vals) {
+  if (vals.size() != 1) {
+    throw Exception("Wrong number of parameters for null");
+  }
+  if (isList(vals[0])) {
+    return !toList(vals[0]).asList();
   }
+  return vals[0].str() == "";
 }
 
-std::string Interpreter::getTail(const std::string &val) const {
-  if (!isList(val) && !memory.listexists(val)) {
-    throw Exception("Tail called on a non list");
-  } else {
-    std::string tail = listSplit(strtolist(val)).second;
-    if (tail == " ") {
-      throw Exception("Tail called on null list");
-    } else {
-      return tail;
+/**
+ * element
+ * @param cell a cell of a list
+ * @return the value of its element, evaluated if it is an expression
+ */
+Value Interpreter::element(const Cell &cell) {
+  return cell.expression ? eval(*cell.expression) : cell.head;
+}
+
+/**
+ * map
+ * @param vals a function of one parameter and a list
+ * @return the list of the function applied to every element
+ */
+Value Interpreter::map(const std::vector<Value> &vals) {
+  if (vals.size() != 2) {
+    throw Exception("Wrong number of parameters for map");
+  }
+  const Callee callee = resolve(vals[0]);
+  const Value list = toList(vals[1]);
+  std::vector<Value> results;
+  std::vector<Value> args(1);
+  for (const Cell *cell = list.asList().get(); cell != nullptr;
+       cell = cell->tail.get()) {
+    args[0] = element(*cell);
+    results.push_back(apply(callee, args));
+  }
+  return Value::listOf(results);
+}
+
+/**
+ * filter
+ * @param vals a function of one parameter returning a boolean and a list
+ * @return the list of the elements the function is true for
+ */
+Value Interpreter::filter(const std::vector<Value> &vals) {
+  if (vals.size() != 2) {
+    throw Exception("Wrong number of parameters for filter");
+  }
+  const Callee callee = resolve(vals[0]);
+  const Value list = toList(vals[1]);
+  std::vector<Value> kept;
+  std::vector<Value> args(1);
+  for (const Cell *cell = list.asList().get(); cell != nullptr;
+       cell = cell->tail.get()) {
+    args[0] = element(*cell);
+    Value keep = apply(callee, args);
+    if (!isBoolean(keep)) {
+      throw Exception("Function " + callee.name +
+                      " given to filter must return a boolean");
+    }
+    if (toBoolean(keep)) {
+      kept.push_back(std::move(args[0]));
     }
   }
+  return Value::listOf(kept);
 }
 
-std::string Interpreter::cons(const std::vector<std::string> &vals) {
+/**
+ * reduce- folds a list from the left
+ * @param vals a function of two parameters, a starting value and a list
+ * @return the function applied to the starting value and the first element,
+ * then to that result and the second element, and so on
+ */
+Value Interpreter::reduce(const std::vector<Value> &vals) {
   if (vals.size() != 3) {
-    throw Exception("Wrong number of parameters for cons");
+    throw Exception("Wrong number of parameters for reduce");
+  }
+  const Callee callee = resolve(vals[0]);
+  const Value list = toList(vals[2]);
+  std::vector<Value> args = {vals[1], Value()};
+  for (const Cell *cell = list.asList().get(); cell != nullptr;
+       cell = cell->tail.get()) {
+    args[1] = element(*cell);
+    args[0] = apply(callee, args);
   }
-  std::string h = isParens(vals[1]) ? eval(vals[1]) : normalize(vals[1]);
-  std::string t = isParens(vals[2]) ? eval(vals[2]) : strtolist(vals[2]);
-  return getcons(h, t);
+  return args[0];
 }
 
-std::string Interpreter::getcons(const std::string &val,
-                                 const std::string &list) const {
+/**
+ * foldr- folds a list from the right
+ * @param vals a function of two parameters, a starting value and a list
+ * @return the function applied to the last element and the starting value,
+ * then to the element before it and that result, and so on
+ */
+Value Interpreter::foldr(const std::vector<Value> &vals) {
+  if (vals.size() != 3) {
+    throw Exception("Wrong number of parameters for foldr");
+  }
+  const Callee callee = resolve(vals[0]);
+  const std::vector<Value> items = elements(toList(vals[2]));
+  std::vector<Value> args = {Value(), vals[1]};
+  for (auto item = items.rbegin(); item != items.rend(); ++item) {
+    args[0] = *item;
+    args[1] = apply(callee, args);
+  }
+  return args[1];
+}
 
-  return (list != "[]") ? std::string("[") + val + std::string(" ") +
-                              removelist(list) + std::string("]")
-                        : std::string("[") + val + std::string("]");
+/**
+ * elements
+ * @param list a list
+ * @return the values of its elements in order, evaluated
+ */
+std::vector<Value> Interpreter::elements(const Value &list) {
+  std::vector<Value> items;
+  for (const Cell *cell = list.asList().get(); cell != nullptr;
+       cell = cell->tail.get()) {
+    items.push_back(element(*cell));
+  }
+  return items;
 }
 
-bool Interpreter::isNull(const std::vector<std::string> &vals) {
+/**
+ * pmap- map with the elements spread over the threads of the machine
+ * @param vals a function of one parameter and a list
+ * @return the list of the function applied to every element, in order
+ */
+Value Interpreter::pmap(const std::vector<Value> &vals) {
   if (vals.size() != 2) {
-    throw Exception("Wrong number of parameters for null");
+    throw Exception("Wrong number of parameters for pmap");
   }
-  if (isParens(vals[1])) {
-    return "" == removelist(eval(vals[1]));
-  } else {
-    return "" == removelist(strtolist(vals[1]));
+  const Callee callee = resolve(vals[0]);
+  const std::vector<Value> items = elements(toList(vals[1]));
+  std::vector<Value> results(items.size());
+  parallel(items.size(), [&](Interpreter &worker, size_t x) {
+    results[x] = worker.apply(callee, {items[x]});
+  });
+  return Value::listOf(results);
+}
+
+/**
+ * preduce- reduce with the list split into runs reduced in parallel, the
+ * results of neighbouring runs are then combined pairwise like a tree. The
+ * runs only depend on the length of the list, so an associative function
+ * gives the same result as reduce on any machine.
+ * @param vals an associative function of two parameters, a starting value
+ * and a list
+ * @return the function applied to the starting value and the reduced list
+ */
+Value Interpreter::preduce(const std::vector<Value> &vals) {
+  if (vals.size() != 3) {
+    throw Exception("Wrong number of parameters for preduce");
+  }
+  const Callee callee = resolve(vals[0]);
+  const std::vector<Value> items = elements(toList(vals[2]));
+  if (items.empty()) {
+    return vals[1];
+  }
+  std::vector<Value> partial(std::min(items.size(), PREDUCE_LEAVES));
+  parallel(partial.size(), [&](Interpreter &worker, size_t leaf) {
+    const size_t begin = leaf * items.size() / partial.size();
+    const size_t end = (leaf + 1) * items.size() / partial.size();
+    std::vector<Value> args = {items[begin], Value()};
+    for (size_t x = begin + 1; x < end; ++x) {
+      args[1] = items[x];
+      args[0] = worker.apply(callee, args);
+    }
+    partial[leaf] = std::move(args[0]);
+  });
+  while (partial.size() > 1) {
+    std::vector<Value> combined;
+    for (size_t x = 0; x + 1 < partial.size(); x += 2) {
+      combined.push_back(apply(callee, {partial[x], partial[x + 1]}));
+    }
+    if (partial.size() % 2 == 1) {
+      combined.push_back(partial.back());
+    }
+    partial = std::move(combined);
   }
+  return apply(callee, {vals[1], partial[0]});
 }
 
-bool Interpreter::isLibraryCall(const std::string &vals) const {
-  std::vector<std::string> libraryDotFunc = split(vals, '.');
-  return (libraryDotFunc.size() == 2 &&
-          memory.libraryExists(libraryDotFunc[0]));
+/**
+ * parallel- runs tasks on the shared thread pool
+ * @param count the number of tasks
+ * @param task called with the interpreter to run it on and its index. This
+ * interpreter runs the tasks of the calling thread, every other thread of
+ * its pool has a worker of its own. Workers are kept between calls and
+ * copy the definitions again only when more were made since.
+ */
+void Interpreter::parallel(
+    size_t count, const std::function<void(Interpreter &, size_t)> &task) {
+  if (!pool) {
+    size_t threads = options.threads != 0
+                         ? options.threads
+                         : std::max(1u, std::thread::hardware_concurrency());
+    pool = std::make_unique<ThreadPool>(threads - 1);
+    workers.resize(pool->size());
+    for (size_t x = 1; x < workers.size(); ++x) {
+      workers[x].reset(new Interpreter(*this, Worker()));
+    }
+  }
+  for (size_t x = 1; x < workers.size(); ++x) {
+    if (workers[x]->memory.definitioncount() != memory.definitioncount()) {
+      workers[x]->memory.share(memory);
+    }
+  }
+  pool->run(count, [&](size_t thread, size_t index) {
+    if (thread == 0) {
+      task(*this, index);
+      return;
+    }
+    char marker;
+    workers[thread]->stackstart = reinterpret_cast<uintptr_t>(&marker);
+    task(*workers[thread], index);
+  });
 }
 
-std::string Interpreter::import(const std::vector<std::string> &vals) {
-  if (vals.size() != 2) {
-    throw Exception("Wrong number of parameters for include");
+/**
+ * resolve
+ * @param fn the fn parameter of a list function
+ * @return the builtin or function it names
+ */
+Interpreter::Callee Interpreter::resolve(const Value &fn) const {
+  Callee callee{fn.str(), Builtin::None, nullptr};
+  callee.builtin = Builtins::find(callee.name);
+  if (callee.builtin == Builtin::None) {
+    callee.function = callable(callee.name);
   }
-  std::string lib = isParens(vals[1]) ? eval(vals[1]) : strtostr(vals[1]);
-  if (memory.libraryExists(lib)) {
-    throw Exception("Library " + lib + " does not exist");
+  return callee;
+}
+
+/**
+ * apply- calls the fn parameter of a list function for one element
+ * @param callee the resolved fn parameter
+ * @param args the evaluated parameters
+ * @return what the call returns
+ */
+Value Interpreter::apply(const Callee &callee,
+                         const std::vector<Value> &args) {
+  if (callee.builtin != Builtin::None) {
+    return callBuiltIn(callee.builtin, args);
+  } else if (callee.function == nullptr ||
+             callee.function->kind != FunctionKind::Function) {
+    return invoke(callee.name, args);
+  } else if (args.size() != callee.function->parameters.size()) {
+    throw Exception("Wrong number of parameters for call to function " +
+                    callee.name);
   }
-  if (memory.librayImported(lib)) {
-    throw Exception("Library " + lib + " already imported");
+  CallScope scope(*this, callee.function->name);
+  scope.enter(*callee.function, args);
+  return execute(*callee.function);
+}
+
+/**
+ * isLibraryCall
+ * @param name the first word of an expression
+ * @return if the word is library.function for a library that exists
+ */
+bool Interpreter::isLibraryCall(const std::string &name) const {
+  // most words have no dot at all, those are answered without allocating
+  const size_t dot = name.find('.');
+  if (dot == std::string::npos ||
+      name.find('.', dot + 1) != std::string::npos) {
+    return false;
+  }
+  return memory.libraryExists(name.substr(0, dot));
+}
+
+/**
+ * evaluated
+ * @param value an argument of a native function
+ * @return the value with the parenthesised elements of its lists, nested
+ * lists included, evaluated
+ */
+Value Interpreter::evaluated(const Value &value) {
+  if (!unevaluated(value)) {
+    return value;
+  }
+  std::vector<Value> elements;
+  for (const Cell *cell = value.asList().get(); cell != nullptr;
+       cell = cell->tail.get()) {
+    elements.push_back(evaluated(element(*cell)));
   }
-  includeLibrary(lib);
-  return "";
+  return Value::listOf(elements);
 }
 
-void Interpreter::includeLibrary(const std::string &libraryName) {
-  memory.importLibrary(libraryName);
+/**
+ * callNative
+ * @param native a function registered with defineNative
+ * @param params the evaluated parameters
+ * @return what the function returns
+ */
+Value Interpreter::callNative(const NativeFunction &native,
+                              const std::vector<Value> &params) {
+  if (params.size() != native.types.size()) {
+    throw Exception("Wrong number of parameters for call to function " +
+                    native.name);
+  }
+  // arguments that already have their declared types are passed as they are
+  size_t x = 0;
+  while (x < params.size() && params[x].typeName() == native.types[x] &&
+         !unevaluated(params[x])) {
+    ++x;
+  }
+  std::vector<Value> converted;
+  if (x != params.size()) {
+    converted.reserve(params.size());
+    for (x = 0; x < params.size(); ++x) {
+      converted.push_back(
+          evaluated(memory.convert(native.types[x], params[x])));
+    }
+  }
+  CallScope scope(*this, native.name);
+  const uint64_t start = tracer ? tracer->now() : 0;
+  Value result = native.body(converted.empty() ? params : converted);
+  if (tracer) {
+    tracer->span(native.name, "native", start);
+  }
+  return result;
 }
@@ -9,118 +9,263 @@
 #ifndef MONET_INTERPRETER_H
 #define MONET_INTERPRETER_H
 
+#include "Compiler.h"
 #include "Exception.h"
 #include "Memory.h"
+#include "ModuleCache.h"
+#include "Parser.h"
+#include "Profiler.h"
+#include "VM.h"
+#include "Value.h"
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <string_view>
 #include <vector>
-#include <boost/multiprecision/mpfr.hpp>
 
-typedef  boost::multiprecision::number< boost::multiprecision::mpfr_float_backend<300>>  num;
 
 
+class ThreadPool;
+
+enum class Engine { Tree, VM };
+
+struct Options {
+  // which engine runs the bodies of defined functions
+  Engine engine = Engine::VM;
+  // byte budgets of the defmem results, 0 for no limit
+  size_t memoBudget = 0;
+  size_t memoFunctionBudget = 0;
+  // print the memo table counters to stderr at exit
+  bool memoStats = false;
+  // threads missing on a defmem call another thread is computing wait for
+  // its result instead of computing it again
+  bool memoWait = false;
+  // file that keeps defmem results between runs, none if empty
+  std::string memoCache;
+  // directory that keeps parsed program files between runs, none if empty
+  std::string moduleCache;
+  // the most nested function calls, 0 for no limit
+  size_t maxDepth = 1000000;
+  // threads of the parallel builtins, 0 for one per core
+  size_t threads = 0;
+  // flush stdout after every printed value instead of at flush points
+  bool unbuffered = false;
+  // print the calls and time of every function to stderr at exit
+  bool profile = false;
+  // file the calls are traced to, none if empty
+  std::string trace;
+  // how much native stack nested calls of the tree engine may take
+  size_t nativeStack = 4 << 20;
+  // where read reads from, printing goes and reports and warnings go
+  std::istream *input = &std::cin;
+  std::ostream *output = &std::cout;
+  std::ostream *errors = &std::cerr;
+};
+
 class Interpreter {
+  friend class VM;
+
 public:
-  Interpreter();
-  Interpreter(std::string filename);
+  explicit Interpreter(const Options &options = Options());
+  ~Interpreter();
+
+  void repl();
+  void runFile(const std::string &filename);
+  Value runSource(const std::string &source);
+  Value callFunction(const std::string &name, const std::vector<Value> &args);
+  void defineNative(const std::string &name,
+                    const std::vector<std::string> &types, Native body);
+  size_t each(const std::string &name);
+  void finish();
 
 private:
+  // the worker constructor, see Interpreter.cpp
+  struct Worker {};
+  Interpreter(const Interpreter &parent, Worker);
+
   // helper functions
+  Value top(const std::function<Value()> &body);
   void interpret();
-  void repl();
-  std::vector<std::string> loadCodeFromFile(const std::string &filename);
-  std::string eval(const std::string &value);
-  std::string evalBuiltIns(const std::string &value,
-                           const std::vector<std::string> &words);
-  std::vector<std::string> split(const std::string &str,
-                                 char delim = ' ') const;
-  std::pair<std::string, std::string> listSplit(const std::string &list) const;
-  bool isString(const std::string &val) const;
-  bool isList(const std::string &val) const;
-
-  int strToInt(const std::string &val) const;
-  num strToNum(const std::string &val) const;
-  bool strtobool(const std::string &val) const;
-  std::string strtostr(const std::string &str) const;
-  std::string strtolist(const std::string &val) const;
-  std::string normalize(const std::string &val) const;
-  
-  std::string removequotes(const std::string &original) const;
-  bool isParens(const std::string &statement) const;
-  std::string removeparens(const std::string &original) const;
-  std::string removelist(const std::string &original) const;
-  bool isNumber(const std::string &value) const;
-  bool isBoolean(const std::string &value) const;
-
-  std::string normalizenumber(num x) const;
-  std::string normalizebool(bool x) const;
-  std::vector<bool> parameterstobool(const std::vector<std::string> &vals);
-  std::vector<num> parameterstonums(const std::vector<std::string> &vals);
-  std::vector<std::string> evalParameters(const std::vector<std::string> &vals);
+  std::vector<Node> loadCodeFromFile(const std::string &filename);
+  std::vector<Node> readModule(const std::string &filename) const;
+  Value eval(const Node &statement);
+  Value evalBuiltIns(Builtin builtin, const Node &expression);
+  Value callBuiltIn(Builtin builtin, const std::vector<Value> &params);
+  Value profileBuiltIn(Builtin builtin, const std::vector<Value> &params);
+  Value runBuiltIn(Builtin builtin, const std::vector<Value> &params);
+  Value evalArgument(const Node &argument);
+  Value lookup(Symbol symbol, uint32_t slot = NO_SLOT) const;
+  Symbol symbolOf(const Node &word) const;
+  bool isList(const Value &val) const;
+  Value toList(const Value &val) const;
+
+  int toInt(const Value &val) const;
+  num toNumber(const Value &val) const;
+  bool toBoolean(const Value &val) const;
+  bool isNumber(const Value &value) const;
+  bool isBoolean(const Value &value) const;
+
+  std::vector<bool> parameterstobool(const std::vector<Value> &vals);
+  std::vector<num> parameterstonums(const std::vector<Value> &vals);
+  std::vector<Value> evalParameters(const Node &expression);
 
   // command functions for the interpreting
   void printcode();
-  void quit(const std::vector<std::string> &vals);
-  void print(const std::vector<std::string> &vals);
-  void println(const std::vector<std::string> &vals);
-  void declarestring(const std::vector<std::string> &vals);
-  void declareboolean(const std::vector<std::string> &vals);
-  void declarenum(const std::vector<std::string> &vals);
-  void declarelist(const std::vector<std::string> &vals);
-  std::string read(const std::vector<std::string> &vals);
-  std::string ifstatement(const std::vector<std::string> &vals);
+  void quit(const std::vector<Value> &vals);
+  void print(const std::vector<Value> &vals);
+  void println(const std::vector<Value> &vals);
+  void write(const std::vector<Value> &vals);
+  void flush();
+  void declarestring(const Node &expression);
+  void declareboolean(const Node &expression);
+  void declarenum(const Node &expression);
+  void declarelist(const Node &expression);
+  void declare(const std::string &type, Symbol name,
+               const Value &value);
+  Value read(const Node &expression);
+  Value ifstatement(const Node &expression);
+  const Node &branch(const Node &expression);
 
   // function functions
-  void define(const std::vector<std::string> &vals);
-  std::string call(const std::vector<std::string> &vals);
-  void subroutine(const std::vector<std::string> &vals);
-  std::string callsubroutine(const std::string &name);
-  void defmem(const std::vector<std::string> &vals);
-  std::string callmem(const std::vector<std::string> &vals);
-  void load(const std::vector<std::string> &vals);
+  void define(const Function &function);
+  std::shared_ptr<const Function> compile(const Function &function) const;
+  Value invoke(const std::string &name, const std::vector<Value> &params);
+  const Function *callable(const std::string &name) const;
+  Value call(const std::string &name, const std::vector<Value> &params);
+  void subroutine(const Function &function);
+  Value callsubroutine(const std::string &name);
+  void defmem(const Function &function);
+  Value callmem(const std::string &name, const std::vector<Value> &params);
+  Value memstats(const std::vector<Value> &vals);
+  void printmemstats() const;
+  void printprofile();
+  Value execute(const Function &function);
+  Value run(const Function &function);
+  Value evalTail(const Node &argument);
+
+  /**
+   * Callee- the fn parameter of a list function, resolved once for all the
+   * elements it is applied to
+   */
+  struct Callee {
+    std::string name;
+    Builtin builtin;
+    const Function *function;
+  };
+  Callee resolve(const Value &fn) const;
+  Value apply(const Callee &callee, const std::vector<Value> &args);
+  void record(std::string_view line, const Callee &callee,
+              std::vector<Value> &args);
+  void load(const std::vector<Value> &vals);
 
   // Math functions
-  num add(const std::vector<std::string> &vals);
-  num sub(const std::vector<std::string> &vals);
-  num mul(const std::vector<std::string> &vals);
-  num div(const std::vector<std::string> &vals);
+  num add(const std::vector<Value> &vals);
+  num sub(const std::vector<Value> &vals);
+  num mul(const std::vector<Value> &vals);
+  num div(const std::vector<Value> &vals);
 
   // logic functions
-  bool andfunc(const std::vector<std::string> &vals);
-  bool orfunc(const std::vector<std::string> &vals);
-  bool notfunc(const std::vector<std::string> &vals);
-  bool nandfunc(const std::vector<std::string> &vals);
-  bool norfunc(const std::vector<std::string> &vals);
-  bool xorfunc(const std::vector<std::string> &vals);
-  bool xnorfunc(const std::vector<std::string> &vals);
+  bool andfunc(const std::vector<Value> &vals);
+  bool orfunc(const std::vector<Value> &vals);
+  bool notfunc(const std::vector<Value> &vals);
+  bool nandfunc(const std::vector<Value> &vals);
+  bool norfunc(const std::vector<Value> &vals);
+  bool xorfunc(const std::vector<Value> &vals);
+  bool xnorfunc(const std::vector<Value> &vals);
 
   // Equality functions
-  int comparison(const std::vector<std::string> &vals);
+  int comparison(const std::vector<Value> &vals);
 
   // List functions
-  std::string head(const std::vector<std::string> &vals);
-  std::string getHead(const std::string &val) const;
-  std::string tail(const std::vector<std::string> &vals);
-  std::string getTail(const std::string &val) const;
-  std::string cons(const std::vector<std::string> &vals);
-  std::string getcons(const std::string &val, const std::string &list) const;
-  bool isNull(const std::vector<std::string> &vals);
+  Value head(const std::vector<Value> &vals);
+  Value tail(const std::vector<Value> &vals);
+  Value cons(const std::vector<Value> &vals);
+  bool isNull(const std::vector<Value> &vals);
+  Value element(const Cell &cell);
+  Value map(const std::vector<Value> &vals);
+  Value filter(const std::vector<Value> &vals);
+  Value reduce(const std::vector<Value> &vals);
+  Value foldr(const std::vector<Value> &vals);
+  std::vector<Value> elements(const Value &list);
+
+  // Parallel functions
+  Value pmap(const std::vector<Value> &vals);
+  Value preduce(const std::vector<Value> &vals);
+  void parallel(size_t count,
+                const std::function<void(Interpreter &, size_t)> &task);
 
   // Library Functions
-  bool isLibraryCall(const std::string &vals) const;
-  std::string import(const std::vector<std::string> &vals);
-  void includeLibrary(const std::string &libraryName);
+  bool isLibraryCall(const std::string &name) const;
+  Value callNative(const NativeFunction &native,
+                   const std::vector<Value> &params);
+  Value evaluated(const Value &value);
+
+  /**
+   * CallScope- the profile entry and memory frame of a call, left when the
+   * scope ends whether the call returned or threw, so a native function that
+   * catches an error of a call back into the interpreter goes on in its own
+   * frame
+   */
+  class CallScope {
+  public:
+    CallScope(Interpreter &interpreter, std::string_view name);
+    ~CallScope();
+    CallScope(const CallScope &) = delete;
+    CallScope &operator=(const CallScope &) = delete;
+    void enter(const Function &function, const std::vector<Value> &args);
+    void release();
+
+  private:
+    // null once released
+    Interpreter *interpreter;
+    bool entered = false;
+  };
+
+  /**
+   * TailCall- a call the tree walker returns without making, it is run in
+   * the frame of the function that returned it
+   */
+  struct TailCall {
+    const Function *function = nullptr;
+    std::vector<Value> params;
+  };
 
   // memory
-  std::vector<std::string> code;
+  std::vector<Node> code;
+  TailCall tailcall;
+  // where the native stack was when the program started
+  uintptr_t stackstart = 0;
+  // set while top runs code
+  bool running = false;
   Memory memory;
-
-  // Parsing words
-  const std::string FUNCTION_DECLARATION_NAME = "define";
-  const std::string FUNCTION_END_NAME = "end";
-  const std::string SUBROUTINE_DECLARATION_NAME = "subroutine";
-  const std::string MEM_DECLARATION_NAME = "defmem";
+  Parser parser;
+  Compiler compiler;
+  VM vm;
+  const Options options;
+  // started by the first parallel builtin, along with a worker for every
+  // thread of the pool but the calling one, both kept for the life of the
+  // interpreter
+  std::unique_ptr<ThreadPool> pool;
+  std::vector<std::unique_ptr<Interpreter>> workers;
+  // held while printing, shared with the workers
+  std::shared_ptr<std::mutex> printing;
+  // results of each waiting to be written, printing writes them out first
+  std::string pending;
+  // only set with the module cache option
+  std::unique_ptr<ModuleCache> modules;
+  // the files load has run, by their canonical path
+  std::set<std::string> loaded;
+  // only set with the profile option, so a run without it only pays a check
+  std::unique_ptr<Profiler> profiler;
+  // only set with the trace option, shared with the workers
+  std::shared_ptr<Tracer> tracer;
+  // set for a worker, which reports nothing when it is destroyed
+  bool worker = false;
+  // set once finish has run
+  bool finished = false;
 };
 
 #endif // MONET_INTERPRETER_H
@@ -0,0 +1,292 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: MemoCache.cpp
+ */
+
+#include "MemoCache.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+const std::string HEADER = "monet-memo 1";
+
+void skipSpace(const std::string &in, size_t &pos) {
+  while (pos < in.length() && isspace(in[pos])) {
+    ++pos;
+  }
+}
+
+bool readCount(const std::string &in, size_t &pos, uint64_t &count) {
+  size_t start = pos;
+  count = 0;
+  while (pos < in.length() && isdigit(in[pos])) {
+    count = count * 10 + (in[pos++] - '0');
+  }
+  return pos != start;
+}
+} // namespace
+
+/**
+ * Constructor
+ * @param path the cache file, it is created on save if it does not exist
+ * @param errors where problems with the file are reported
+ */
+MemoCache::MemoCache(const std::string &path, std::ostream &errors)
+    : path(path), errors(&errors) {
+  load();
+}
+
+/**
+ * restore- called when a defmem function is defined
+ * @param name the function
+ * @param source the text of its definition
+ * @return the results kept for this exact definition, results of an older
+ * definition are dropped
+ */
+std::vector<MemoEntry> MemoCache::restore(const std::string &name,
+                                          const std::string &source) {
+  uint64_t current = hash(source);
+  defined[name] = current;
+  auto record = records.find(name);
+  if (record == records.end() || record->second.hash != current) {
+    records[name] = Record{current, {}};
+    return {};
+  }
+  return record->second.entries;
+}
+
+/**
+ * update
+ * @param name a function defined in this run
+ * @param entries its results as they should be saved
+ */
+void MemoCache::update(const std::string &name,
+                       std::vector<MemoEntry> entries) {
+  records[name].entries = std::move(entries);
+}
+
+std::vector<std::string> MemoCache::restored() const {
+  std::vector<std::string> names;
+  for (const auto &function : defined) {
+    names.push_back(function.first);
+  }
+  return names;
+}
+
+/**
+ * save- rewrites the cache file, functions not defined in this run keep
+ * their old results
+ */
+void MemoCache::save() const {
+  std::string out = HEADER + "\n";
+  for (const auto &record : records) {
+    for (const MemoEntry &entry : record.second.entries) {
+      std::string line = std::to_string(record.first.length()) + ":" +
+                         record.first + " " +
+                         std::to_string(record.second.hash) + " " +
+                         std::to_string(entry.first.size());
+      bool kept = true;
+      for (const Value &argument : entry.first) {
+        line += " ";
+        kept = kept && encode(argument, line);
+      }
+      line += " ";
+      kept = kept && encode(entry.second, line);
+      if (kept) {
+        out += line + "\n";
+      }
+    }
+  }
+  // written beside the cache and renamed over it, so a reader never sees
+  // half a file, even when runs save the same cache at once
+  const std::string temp =
+      path + "." +
+      std::to_string(
+          std::chrono::steady_clock::now().time_since_epoch().count()) +
+      ".tmp";
+  std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+  file << out;
+  file.close();
+  if (!file || std::rename(temp.c_str(), path.c_str()) != 0) {
+    std::remove(temp.c_str());
+    *errors << "Unable to write memo cache " << path << std::endl;
+  }
+}
+
+/**
+ * hash
+ * @param source the text of a definition
+ * @return its 64 bit FNV-1a hash, the same on every platform and run
+ */
+uint64_t MemoCache::hash(std::string_view source) {
+  uint64_t h = 14695981039346656037ULL;
+  for (unsigned char c : source) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+void MemoCache::load() {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  const std::string in = buffer.str();
+  if (in.compare(0, HEADER.length(), HEADER) != 0) {
+    *errors << "Ignoring memo cache " << path << " of an unknown format"
+            << std::endl;
+    return;
+  }
+  size_t pos = HEADER.length();
+  while (true) {
+    skipSpace(in, pos);
+    if (pos == in.length()) {
+      return;
+    }
+    std::string name;
+    uint64_t hash, count;
+    MemoEntry entry;
+    bool valid = decodeText(in, pos, name);
+    skipSpace(in, pos);
+    valid = valid && readCount(in, pos, hash);
+    skipSpace(in, pos);
+    valid = valid && readCount(in, pos, count);
+    for (uint64_t i = 0; valid && i < count; ++i) {
+      entry.first.emplace_back();
+      valid = decode(in, pos, entry.first.back());
+    }
+    valid = valid && decode(in, pos, entry.second);
+    if (!valid) {
+      *errors << "Memo cache " << path << " is damaged, ignoring the rest"
+              << std::endl;
+      return;
+    }
+    Record &record = records[name];
+    if (record.hash != hash) {
+      record = Record{hash, {}};
+    }
+    record.entries.push_back(std::move(entry));
+  }
+}
+
+/**
+ * encode
+ * @param value the value to write
+ * @param out where the text goes
+ * @return false if the value cannot be kept
+ */
+bool MemoCache::encode(const Value &value, std::string &out) {
+  std::string text;
+  switch (value.type()) {
+  case Value::Type::None:
+    out += "_";
+    return true;
+  case Value::Type::Boolean:
+    out += value.asBoolean() ? "b1" : "b0";
+    return true;
+  case Value::Type::Number:
+    text = value.asNumber().repr();
+    out += "n" + std::to_string(text.length()) + ":" + text;
+    return true;
+  case Value::Type::String:
+    out += "s" + std::to_string(value.asString().length()) + ":" +
+           value.asString();
+    return true;
+  case Value::Type::Function:
+    out += "f" + std::to_string(value.asString().length()) + ":" +
+           value.asString();
+    return true;
+  case Value::Type::List: {
+    uint64_t count = 0;
+    std::string elements;
+    for (const Cell *cell = value.asList().get(); cell != nullptr;
+         cell = cell->tail.get()) {
+      if (cell->expression || !encode(cell->head, elements)) {
+        return false;
+      }
+      elements += " ";
+      ++count;
+    }
+    out += "l" + std::to_string(count) + ": " + elements;
+    return true;
+  }
+  }
+  return false;
+}
+
+bool MemoCache::decode(const std::string &in, size_t &pos, Value &value) {
+  skipSpace(in, pos);
+  if (pos == in.length()) {
+    return false;
+  }
+  const char kind = in[pos++];
+  std::string text;
+  uint64_t count;
+  switch (kind) {
+  case '_':
+    value = Value();
+    return true;
+  case 'b':
+    if (pos == in.length()) {
+      return false;
+    }
+    value = Value::boolean(in[pos++] == '1');
+    return true;
+  case 'n':
+    if (!decodeText(in, pos, text) || !Value::isNumeric(text)) {
+      return false;
+    }
+    value = Value::number(num::parse(text));
+    return true;
+  case 's':
+  case 'f':
+    if (!decodeText(in, pos, text)) {
+      return false;
+    }
+    value = kind == 's' ? Value::string(text) : Value::function(text);
+    return true;
+  case 'l': {
+    if (!readCount(in, pos, count) || count > in.length() ||
+        pos == in.length() || in[pos++] != ':') {
+      return false;
+    }
+    std::vector<Value> elements(count);
+    for (Value &element : elements) {
+      if (!decode(in, pos, element)) {
+        return false;
+      }
+    }
+    value = Value::listOf(elements);
+    return true;
+  }
+  }
+  return false;
+}
+
+/**
+ * decodeText
+ * @param in the cache file
+ * @param pos where the length of the text starts, moved past the text
+ * @param text the length prefixed text that was read
+ * @return false if the text is damaged
+ */
+bool MemoCache::decodeText(const std::string &in, size_t &pos,
+                           std::string &text) {
+  uint64_t length;
+  if (!readCount(in, pos, length) || pos == in.length() || in[pos] != ':' ||
+      in.length() - pos - 1 < length) {
+    return false;
+  }
+  text = in.substr(pos + 1, length);
+  pos += length + 1;
+  return true;
+}
@@ -0,0 +1,58 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: MemoCache.h
+ */
+
+#ifndef MONET_MEMOCACHE_H
+#define MONET_MEMOCACHE_H
+
+#include "MemoTable.h"
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * MemoCache- defmem results kept in a file between runs
+ * Results are filed under the function name and a hash of its definition,
+ * so they are dropped as soon as the definition changes. Results holding
+ * unevaluated list elements are not kept.
+ */
+class MemoCache {
+public:
+  MemoCache(const std::string &path, std::ostream &errors);
+
+  std::vector<MemoEntry> restore(const std::string &name,
+                                 const std::string &source);
+  void update(const std::string &name, std::vector<MemoEntry> entries);
+  std::vector<std::string> restored() const;
+  void save() const;
+
+  static uint64_t hash(std::string_view source);
+
+private:
+  struct Record {
+    uint64_t hash;
+    std::vector<MemoEntry> entries;
+  };
+
+  void load();
+  static bool encode(const Value &value, std::string &out);
+  static bool decode(const std::string &in, size_t &pos, Value &value);
+  static bool decodeText(const std::string &in, size_t &pos,
+                         std::string &text);
+
+  std::string path;
+  // where problems with the file are reported
+  std::ostream *errors;
+  std::map<std::string, Record> records;
+  // the functions defined in this run, their records are rewritten on save
+  std::map<std::string, uint64_t> defined;
+};
+
+#endif // MONET_MEMOCACHE_H
@@ -0,0 +1,190 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: MemoTable.cpp
+ */
+
+#include "MemoTable.h"
+
+namespace {
+// bookkeeping of one entry besides its values: hash node, list node, sizes
+const size_t ENTRY_OVERHEAD = 96;
+} // namespace
+
+/**
+ * setbudget
+ * @param total the most bytes all memoized results may take, 0 for no limit
+ * @param perfunction the most bytes the results of one function may take, 0
+ * for no limit
+ */
+void MemoTable::setbudget(size_t total, size_t perfunction) {
+  budget = total;
+  functionbudget = perfunction;
+  for (auto &table : tables) {
+    evict(table.second);
+  }
+}
+
+/**
+ * find
+ * @param name a memoized function
+ * @param call the arguments of the call
+ * @return the remembered result, null on a miss. The pointer is only valid
+ * until the next insert.
+ */
+const Value *MemoTable::find(const std::string &name,
+                             const std::vector<Value> &call) {
+  auto table = tables.find(name);
+  if (table == tables.end()) {
+    tables[name].stats.misses++;
+    return nullptr;
+  }
+  auto entry = table->second.entries.find(call);
+  if (entry == table->second.entries.end()) {
+    table->second.stats.misses++;
+    return nullptr;
+  }
+  table->second.stats.hits++;
+  std::list<Use> &order = table->second.order;
+  order.splice(order.begin(), order, entry->second.use);
+  entry->second.use->tick = ++tick;
+  return &entry->second.result;
+}
+
+void MemoTable::insert(const std::string &name, const std::vector<Value> &call,
+                       const Value &result) {
+  Table &table = tables[name];
+  size_t size = ENTRY_OVERHEAD + footprint(result);
+  for (const Value &argument : call) {
+    size += footprint(argument);
+  }
+  if ((budget != 0 && size > budget) ||
+      (functionbudget != 0 && size > functionbudget)) {
+    // would evict everything and still not fit
+    return;
+  }
+  auto entry = table.entries.find(call);
+  if (entry != table.entries.end()) {
+    table.stats.bytes -= entry->second.bytes;
+    bytes -= entry->second.bytes;
+    entry->second.result = result;
+    entry->second.bytes = size;
+    table.order.splice(table.order.begin(), table.order, entry->second.use);
+    entry->second.use->tick = ++tick;
+  } else {
+    entry = table.entries.emplace(call, Entry{result, size, {}}).first;
+    table.order.push_front(Use{&entry->first, ++tick});
+    entry->second.use = table.order.begin();
+    table.stats.entries++;
+  }
+  table.stats.bytes += size;
+  bytes += size;
+  evict(table);
+}
+
+/**
+ * evict- drops least recently used results until the budgets are met
+ * @param table the table that just grew, it is the first to shrink when it is
+ * over its own budget
+ */
+void MemoTable::evict(Table &table) {
+  while (true) {
+    Table *victim = nullptr;
+    if (functionbudget != 0 && table.stats.bytes > functionbudget) {
+      victim = &table;
+    } else if (budget != 0 && bytes > budget) {
+      // the table holding the oldest result across all functions
+      for (auto &candidate : tables) {
+        if (!candidate.second.order.empty() &&
+            (victim == nullptr ||
+             candidate.second.order.back().tick < victim->order.back().tick)) {
+          victim = &candidate.second;
+        }
+      }
+    }
+    if (victim == nullptr || victim->order.empty()) {
+      return;
+    }
+    auto entry = victim->entries.find(*victim->order.back().key);
+    victim->stats.bytes -= entry->second.bytes;
+    bytes -= entry->second.bytes;
+    victim->order.pop_back();
+    victim->entries.erase(entry);
+    victim->stats.entries--;
+    victim->stats.evictions++;
+  }
+}
+
+MemoStats MemoTable::stats(const std::string &name) const {
+  auto table = tables.find(name);
+  return table != tables.end() ? table->second.stats : MemoStats();
+}
+
+/**
+ * stats
+ * @return the counters of every memoized function added together
+ */
+MemoStats MemoTable::stats() const {
+  MemoStats total;
+  for (const auto &table : tables) {
+    total.hits += table.second.stats.hits;
+    total.misses += table.second.stats.misses;
+    total.evictions += table.second.stats.evictions;
+    total.entries += table.second.stats.entries;
+    total.bytes += table.second.stats.bytes;
+  }
+  return total;
+}
+
+std::vector<std::string> MemoTable::functions() const {
+  std::vector<std::string> names;
+  for (const auto &table : tables) {
+    names.push_back(table.first);
+  }
+  return names;
+}
+
+/**
+ * entries
+ * @param name a memoized function
+ * @return its remembered results, the most recently used first
+ */
+std::vector<MemoEntry> MemoTable::entries(const std::string &name) const {
+  std::vector<MemoEntry> results;
+  auto table = tables.find(name);
+  if (table != tables.end()) {
+    for (const Use &use : table->second.order) {
+      results.emplace_back(*use.key, table->second.entries.at(*use.key).result);
+    }
+  }
+  return results;
+}
+
+size_t MemoTable::KeyHash::operator()(const std::vector<Value> &key) const {
+  size_t seed = key.size();
+  for (const Value &value : key) {
+    seed ^= value.hash() + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+  }
+  return seed;
+}
+
+/**
+ * footprint
+ * @param value a remembered argument or result
+ * @return roughly how many bytes the value keeps alive, lists are counted
+ * in full even when their cells are shared
+ */
+size_t MemoTable::footprint(const Value &value) {
+  size_t size = sizeof(Value);
+  if (value.isString() || value.isFunction()) {
+    size += sizeof(std::string) + value.asString().capacity();
+  } else if (value.isList()) {
+    for (const Cell *cell = value.asList().get(); cell != nullptr;
+         cell = cell->tail.get()) {
+      size += sizeof(Cell) - sizeof(Value) + footprint(cell->head);
+    }
+  }
+  return size;
+}
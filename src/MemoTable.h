@@ -0,0 +1,81 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: MemoTable.h
+ */
+
+#ifndef MONET_MEMOTABLE_H
+#define MONET_MEMOTABLE_H
+
+#include "Value.h"
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// the arguments of a call and its result
+typedef std::pair<std::vector<Value>, Value> MemoEntry;
+
+struct MemoStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  size_t entries = 0;
+  size_t bytes = 0;
+};
+
+/**
+ * MemoTable- the remembered results of defmem functions
+ * Results are hashed on the argument values. When a byte budget is set the
+ * least recently used results are evicted to stay within it, either for one
+ * function or across all of them. A budget of 0 means no limit.
+ */
+class MemoTable {
+public:
+  struct KeyHash {
+    size_t operator()(const std::vector<Value> &key) const;
+  };
+
+  void setbudget(size_t total, size_t perfunction);
+
+  const Value *find(const std::string &name, const std::vector<Value> &call);
+  void insert(const std::string &name, const std::vector<Value> &call,
+              const Value &result);
+
+  MemoStats stats(const std::string &name) const;
+  MemoStats stats() const;
+  std::vector<std::string> functions() const;
+  std::vector<MemoEntry> entries(const std::string &name) const;
+
+private:
+  struct Use {
+    const std::vector<Value> *key;
+    uint64_t tick;
+  };
+  struct Entry {
+    Value result;
+    size_t bytes;
+    std::list<Use>::iterator use;
+  };
+  struct Table {
+    std::unordered_map<std::vector<Value>, Entry, KeyHash> entries;
+    // most recently used first
+    std::list<Use> order;
+    MemoStats stats;
+  };
+
+  void evict(Table &table);
+  static size_t footprint(const Value &value);
+
+  std::map<std::string, Table> tables;
+  size_t budget = 0;
+  size_t functionbudget = 0;
+  size_t bytes = 0;
+  uint64_t tick = 0;
+};
+
+#endif // MONET_MEMOTABLE_H
@@ -7,115 +7,141 @@
  */
 
 #include "Memory.h"
-#include "Interpreter.h"
-#include <cmath>
 #include <iostream>
-#include <sstream>
-
-typedef std::pair<std::string, bool> strbool;
-
-Memory::Memory() {
-  reservedwords.insert(
-      {"print",  "println", "quit", "boolean", "num",    "string", "read",
-       "add",    "sub",     "mul",  "div",     "and",    "or",     "nand",
-       "nor",    "xor",     "xnor", "if",      "eq",     "ne",     "gt",
-       "lt",     "ge",      "le",   "define",  "return", "end",    "subroutine",
-       "defmem", "load",    "list", "cons",    "head",   "tail",   "null"});
-  libraries.insert({strbool("file", false)});
-  loadLibraries();
+
+/**
+ * Constructor
+ * @param symbols the symbol table, a worker is given the table of its parent
+ */
+Memory::Memory(std::shared_ptr<Symbols> symbols)
+    : memo(std::make_shared<ConcurrentMemo>()), symbols(std::move(symbols)),
+      parser(*this->symbols) {
   enterfn();
 }
 
-std::string Memory::get(const std::string &var) const {
-  if (varexists(var)) {
-    if (getType(var) == "boolean") {
-      if (getboolean(var)) {
-        return "true";
-      } else {
-        return "false";
-      }
-    } else if (getType(var) == "num") {
-      if (fmod(getnum(var), 1) < .000001) {
-        return std::to_string(((int)getnum(var)));
-      } else {
-        return to_string(getnum(var));
-      }
-    } else if (getType(var) == "string") {
-      return getstring(var);
-    } else if (getType(var) == "list") {
-      return getlist(var);
-    } else {
-      std::cerr
-          << "If you are seeing this message something is very, very wrong"
-          << std::endl;
-      return "";
-    }
+const std::shared_ptr<Symbols> &Memory::symboltable() const {
+  return symbols;
+}
 
+/**
+ * definitioncount
+ * @return how many functions, subroutines, defmem and native functions have
+ * been defined, definitions are never replaced so the count only changes
+ * when one is added
+ */
+size_t Memory::definitioncount() const { return definitions; }
+
+/**
+ * share- makes this the memory of a worker of a parallel builtin
+ * @param parent the memory of the interpreter the worker helps, its
+ * definitions are copied and its memo table is shared
+ * Sharing again brings the copies up to date with what the parent defined
+ * since.
+ */
+void Memory::share(const Memory &parent) {
+  functions = parent.functions;
+  subroutines = parent.subroutines;
+  mems = parent.mems;
+  functionnamespace = parent.functionnamespace;
+  subroutinenamespace = parent.subroutinenamespace;
+  memnamespace = parent.memnamespace;
+  libraries = parent.libraries;
+  natives = parent.natives;
+  definitions = parent.definitions;
+  maxdepth = parent.maxdepth;
+  memo = parent.memo;
+  tracer = parent.tracer;
+  errors = parent.errors;
+}
+
+Value Memory::get(const std::string &var) const {
+  const Value *value = findvar(var);
+  if (value != nullptr) {
+    return *value;
   } else {
     throw Exception("Variable " + var + " not found");
   }
 }
 
-std::vector<std::string> Memory::getfn(const std::string &var) const {
-  if (!functioninuse(var)) {
-    throw Exception("Cannot make call to " + var);
-  } else if (!functionbindings.empty()) {
-    if (functionbindings.top().count(var) != 0) {
-      return getfn(functionbindings.top().at(var));
-    }
-  }
-  if (isFunction(var)) {
-    return functions.at(var);
-  } else if (isSubroutine(var)) {
-    return subroutines.at(var);
-  } else if (isMem(var)) {
-    return mems.at(var);
-  } else {
-    throw Exception("Fatal implementation error in the interpreter");
+/**
+ * find
+ * @param symbol the name of a variable
+ * @return the variable in the current frame, null if it is not declared
+ */
+const Value *Memory::find(Symbol symbol) const {
+  const Frame &frame = frames.back();
+  uint32_t slot = frame.layout ? frame.layout->find(symbol) : NO_SLOT;
+  if (slot != NO_SLOT) {
+    return getslot(slot);
   }
-  // The code will never reach this point, this is just to shush the compiler
-  return std::vector<std::string>();
+  auto found = frame.others.find(symbol);
+  return found != frame.others.end() ? &found->second : nullptr;
 }
 
-std::string Memory::getstring(const std::string &var) const {
-  if (!strexists(var)) {
-    throw Exception("Variable " + var + " does not exist");
-  }
-  return strings.top().at(var);
+/**
+ * findvar
+ * @param var the name of a variable
+ * @return the variable in the current frame, null if it is not declared
+ * Names that were never interned cannot be variables, they are not interned
+ * by asking.
+ */
+const Value *Memory::findvar(const std::string &var) const {
+  const Symbol symbol = symbols->find(var);
+  return symbol != NO_SYMBOL ? find(symbol) : nullptr;
 }
 
-bool Memory::getboolean(const std::string &var) const {
-  if (!boolexists(var)) {
-    throw Exception("Variable " + var + " does not exist");
-  }
-  return booleans.top().at(var);
+/**
+ * getslot
+ * @param slot a slot of the current function's layout
+ * @return the variable in the slot, null if it is not declared yet
+ */
+const Value *Memory::getslot(uint32_t slot) const {
+  const Value &value = slots[frames.back().base + slot];
+  return value.isNone() ? nullptr : &value;
 }
 
-num Memory::getnum(const std::string &var) const {
-  if (!numexists(var)) {
-    throw Exception("Variable " + var + " does not exist");
+/**
+ * getfn
+ * @param var a function, subroutine, memoized function or function parameter
+ * @return the definition it names, valid for the life of the memory
+ */
+const Function &Memory::getfn(const std::string &var) const {
+  if (!functioninuse(var)) {
+    throw Exception("Cannot make call to " + var);
+  } else if (isBinding(var)) {
+    return getfn(getBinding(var));
+  }
+  if (isFunction(var)) {
+    return *functions.at(var);
+  } else if (isSubroutine(var)) {
+    return *subroutines.at(var);
+  } else if (isMem(var)) {
+    return *mems.at(var);
   }
-  return nums.top().at(var);
+  throw Exception("Fatal implementation error in the interpreter");
 }
 
-std::string Memory::getlist(const std::string &var) const {
-  if (!listexists(var)) {
-    throw Exception("Variable " + var + " does not exist");
+/**
+ * findfn
+ * @param name a word
+ * @return the define or defmem function of that name, null if there is none
+ */
+const Function *Memory::findfn(const std::string &name) const {
+  auto function = functions.find(name);
+  if (function != functions.end()) {
+    return function->second.get();
   }
-  return lists.top().at(var);
+  auto mem = mems.find(name);
+  return mem != mems.end() ? mem->second.get() : nullptr;
 }
 
 bool Memory::functioninuse(const std::string &val) const {
-  bool inStack = false;
-  if (!functionbindings.empty()) {
-    inStack = functionbindings.top().count(val) != 0;
-  }
   return isBuiltInFn(val) || isFunction(val) || isSubroutine(val) ||
-         isMem(val) || inStack;
+         isMem(val) || isNative(val) || isBinding(val);
 }
 
 bool Memory::isBuiltInFn(const std::string &val) const {
-  return reservedwords.count(val) != 0;
+  return Builtins::find(val) != Builtin::None;
 }
 
 bool Memory::isFunction(const std::string &val) const {
@@ -130,250 +156,335 @@ bool Memory::isMem(const std::string &val) const {
   return memnamespace.count(val) != 0;
 }
 
+bool Memory::isNative(const std::string &val) const {
+  return natives.count(val) != 0;
+}
+
 void Memory::createfunction(const std::string &name,
-                            const std::vector<std::string> &code) {
+                            std::shared_ptr<const Function> code) {
   if (functioninuse(name)) {
     throw Exception("Unable to redefine \"" + name + "\"");
   }
   functionnamespace.insert(name);
-  functions.insert(
-      std::pair<std::string, std::vector<std::string>>(name, code));
+  functions.emplace(name, std::move(code));
+  ++definitions;
 }
 
 void Memory::createsub(const std::string &name,
-                       const std::vector<std::string> &code) {
+                       std::shared_ptr<const Function> code) {
   if (functioninuse(name)) {
     throw Exception("Unable to redefine \"" + name + "\"");
   }
   subroutinenamespace.insert(name);
-  subroutines.insert(
-      std::pair<std::string, std::vector<std::string>>(name, code));
+  subroutines.emplace(name, std::move(code));
+  ++definitions;
 }
 
 void Memory::createmem(const std::string &name,
-                       const std::vector<std::string> &code) {
+                       std::shared_ptr<const Function> code) {
   if (functioninuse(name)) {
     throw Exception("Unable to redefine \"" + name + "\"");
   }
   memnamespace.insert(name);
-  mems.insert(std::pair<std::string, std::vector<std::string>>(name, code));
-}
-
-void Memory::createboolean(const std::string &name, bool value) {
-  if (!varexists(name)) {
-    booleans.top().insert(std::pair<std::string, bool>(name, value));
-    variabletypes.top().insert(
-        std::pair<std::string, std::string>(name, "boolean"));
-  } else if (getType(name) == "boolean") {
-    throw Exception("Reinitialization of variable " + name);
-  } else {
-    throw Exception("Variable " + name + " already initialized as a " +
-                    getType(name));
+  const std::string &source = code->source;
+  mems.emplace(name, std::move(code));
+  ++definitions;
+  if (memcache) {
+    std::vector<MemoEntry> kept = memcache->restore(name, source);
+    // oldest first, so the most recently used result stays the most recent
+    for (auto entry = kept.rbegin(); entry != kept.rend(); ++entry) {
+      memo->insert(name, entry->first, entry->second);
+    }
   }
 }
 
-void Memory::createnum(const std::string &name, num number) {
-  if (!varexists(name)) {
-    nums.top().insert(std::pair<std::string, num>(name, number));
-    variabletypes.top().insert(
-        std::pair<std::string, std::string>(name, "num"));
-  } else if (getType(name) == "num") {
-    throw Exception("Reinitialization of variable " + name);
-  } else {
-    throw Exception("Variable " + name + " already initialized as a " +
-                    getType(name));
-  }
+void Memory::create(const std::string &name, const Value &value) {
+  create(symbols->intern(name), value);
 }
 
-void Memory::createstring(const std::string &name, const std::string &str) {
-  if (!varexists(name)) {
-    strings.top().insert(std::pair<std::string, std::string>(name, str));
-    variabletypes.top().insert(
-        std::pair<std::string, std::string>(name, "string"));
-  } else if (getType(name) == "string") {
-    throw Exception("Reinitialization of variable " + name);
+void Memory::create(Symbol symbol, const Value &value) {
+  const Value *existing = find(symbol);
+  if (existing == nullptr) {
+    Frame &frame = frames.back();
+    uint32_t slot = frame.layout ? frame.layout->find(symbol) : NO_SLOT;
+    if (slot != NO_SLOT) {
+      slots[frame.base + slot] = value;
+    } else {
+      frame.others[symbol] = value;
+    }
+  } else if (existing->typeName() == value.typeName()) {
+    throw Exception("Reinitialization of variable " + symbols->name(symbol));
   } else {
-    throw Exception("Variable " + name + " already initialized as a " +
-                    getType(name));
+    throw Exception("Variable " + symbols->name(symbol) +
+                    " already initialized as a " + existing->typeName());
   }
 }
 
-void Memory::createlist(const std::string &name, const std::string &list) {
-  if (!varexists(name)) {
-    lists.top().insert(std::pair<std::string, std::string>(name, list));
-    variabletypes.top().insert(
-        std::pair<std::string, std::string>(name, "list"));
-  } else if (getType(name) == "list") {
-    throw Exception("Reinitialization of variable " + name);
-  } else {
-    throw Exception("Variable " + name + " already initialized as a " +
-                    getType(name));
-  }
+bool Memory::varexists(const std::string &var) const {
+  return findvar(var) != nullptr;
 }
 
-bool Memory::boolexists(const std::string &var) const {
-  return (booleans.top().count(var) != 0);
+void Memory::enterfn() {
+  frames.push_back(Frame{nullptr, slots.size(), {}, nullptr, 0});
 }
 
-bool Memory::strexists(const std::string &var) const {
-  return (strings.top().count(var) != 0);
+void Memory::enterfn(const std::vector<Value> &vals,
+                     const Function &fndefinition) {
+  // the top level has the first frame
+  if (maxdepth != 0 && frames.size() > maxdepth) {
+    throw Exception("Maximum call depth of " + std::to_string(maxdepth) +
+                    " exceeded in " + fndefinition.name);
+  }
+  const size_t base = slots.size();
+  slots.resize(base + fndefinition.layout.names.size());
+  try {
+    for (uint32_t x = 0; x < fndefinition.parameters.size(); ++x) {
+      slots[base +
+            fndefinition.layout.find(fndefinition.parameters[x].symbol)] =
+          convert(fndefinition.parameters[x].type, vals[x]);
+    }
+  } catch (...) {
+    slots.resize(base);
+    throw;
+  }
+  frames.push_back(Frame{&fndefinition.layout, base, {}, &fndefinition,
+                         tracer != nullptr ? tracer->now() : 0});
 }
 
-bool Memory::numexists(const std::string &var) const {
-  return (nums.top().count(var) != 0);
+/**
+ * convert
+ * @param type the declared type of a parameter
+ * @param value the argument passed for it
+ * @return the argument as that type, the same value if it already is
+ */
+Value Memory::convert(const std::string &type, const Value &value) const {
+  if (type == "boolean") {
+    if (!value.isBoolean()) {
+      *errors << "Calling strtobool on nonboolean value \"" << value.str()
+              << "\"" << std::endl;
+    }
+    return value.isBoolean() ? value
+                             : Value::boolean(value.str() == "true" ||
+                                              value.str() == "1");
+  } else if (type == "string") {
+    return value.isString() ? value : Value::string(value.str());
+  } else if (type == "list") {
+    return (value.isString() && parser.isListText(value.asString()))
+               ? parser.parseList(value.asString()).value
+               : value;
+  } else if (type == "num") {
+    if (value.isNumber()) {
+      return value;
+    } else if (!Value::isNumeric(value.str())) {
+      throw Exception("Unable to pass \"" + value.str() + "\" as a num");
+    }
+    return Value::number(num::parse(value.str()));
+  } else if (type == "fn") {
+    return value.isFunction() ? value : Value::function(value.str());
+  }
+  *errors << "Type " << type << " does not exist" << std::endl;
+  return Value();
 }
 
-bool Memory::listexists(const std::string &var) const {
-  return (lists.top().count(var) != 0);
+/**
+ * replacefn- leaves the current call and enters another in its place, as a
+ * tail call does
+ * @param vals the parameters of the call
+ * @param fndefinition the function called
+ * If the parameters cannot be converted, the current call is kept.
+ */
+void Memory::replacefn(const std::vector<Value> &vals,
+                       const Function &fndefinition) {
+  // converted above the current frame first, then moved down over it
+  const size_t top = slots.size();
+  const size_t count = fndefinition.layout.names.size();
+  slots.resize(top + count);
+  try {
+    for (uint32_t x = 0; x < fndefinition.parameters.size(); ++x) {
+      slots[top +
+            fndefinition.layout.find(fndefinition.parameters[x].symbol)] =
+          convert(fndefinition.parameters[x].type, vals[x]);
+    }
+  } catch (...) {
+    slots.resize(top);
+    throw;
+  }
+  Frame &frame = frames.back();
+  if (tracer != nullptr && frame.function != nullptr) {
+    tracer->span(frame.function->name, "function", frame.start);
+  }
+  std::move(slots.begin() + top, slots.end(), slots.begin() + frame.base);
+  slots.resize(frame.base + count);
+  frame = Frame{&fndefinition.layout, frame.base, {}, &fndefinition,
+                tracer != nullptr ? tracer->now() : 0};
 }
 
-bool Memory::varexists(const std::string &var) const {
-  return (variabletypes.top().count(var) != 0);
+void Memory::leavefn() {
+  if (tracer != nullptr && frames.back().function != nullptr) {
+    tracer->span(frames.back().function->name, "function",
+                 frames.back().start);
+  }
+  slots.resize(frames.back().base);
+  frames.pop_back();
 }
 
-void Memory::enterfn() {
-  variabletypes.push(std::map<std::string, std::string>());
-  booleans.push(std::map<std::string, bool>());
-  nums.push(std::map<std::string, num>());
-  strings.push(std::map<std::string, std::string>());
-  lists.push(std::map<std::string, std::string>());
-}
-
-void Memory::enterfn(const std::vector<std::string> &vals,
-                     const std::vector<std::string> &fndefinition) {
-
-  std::map<std::string, std::string> nexttypes =
-      std::map<std::string, std::string>();
-  std::map<std::string, bool> nextbool = std::map<std::string, bool>();
-  std::map<std::string, std::string> nextstring =
-      std::map<std::string, std::string>();
-  std::map<std::string, std::string> nextlist =
-      std::map<std::string, std::string>();
-  std::map<std::string, num> nextnum = std::map<std::string, num>();
-  std::map<std::string, std::string> nextfns =
-      std::map<std::string, std::string>();
-  num numberOfParameters = (fndefinition.size() - 3) / 2.0;
-  for (uint32_t x = 0; x < numberOfParameters; ++x) {
-    std::string type = fndefinition.at((2 * x) + 3);
-    std::string name = fndefinition.at((2 * x) + 4);
-    std::string value = vals[x];
-    if (type == "boolean") {
-      nextbool.insert(std::pair<std::string, bool>(name, strtobool(value)));
-      nexttypes.insert(std::pair<std::string, std::string>(name, "boolean"));
-    } else if (type == "string") {
-      nextstring.insert(
-          std::pair<std::string, std::string>(name, strtostr(value)));
-      nexttypes.insert(std::pair<std::string, std::string>(name, "string"));
-    } else if (type == "list") {
-      nextlist.insert(
-          std::pair<std::string, std::string>(name, strtolist(value)));
-      nexttypes.insert(std::pair<std::string, std::string>(name, "list"));
-    } else if (type == "num") {
-      nextnum.insert(std::pair<std::string, num>(name, strtonum(value)));
-      nexttypes.insert(std::pair<std::string, std::string>(name, "num"));
-    } else if (type == "fn") {
-      nextfns.insert(std::pair<std::string, std::string>(name, value));
-    } else {
-      std::cerr << "Type " << type << " does not exist" << std::endl;
-    }
+/**
+ * leaveall- leaves every function call, back to the top level, after code
+ * failed in the middle of them
+ */
+void Memory::leaveall() {
+  while (frames.size() > 1) {
+    leavefn();
   }
-  variabletypes.push(nexttypes);
-  booleans.push(nextbool);
-  nums.push(nextnum);
-  strings.push(nextstring);
-  lists.push(nextlist);
-  functionbindings.push(nextfns);
 }
 
-void Memory::leavefn() {
-  // So much popping you would think someone is making popcorn
-  // I understand if you stop reading the code after that comment
-  variabletypes.pop();
-  booleans.pop();
-  strings.pop();
-  nums.pop();
-  lists.pop();
-  functionbindings.pop();
-}
+/**
+ * setmaxdepth
+ * @param depth the most function calls that may be nested, 0 for no limit
+ */
+void Memory::setmaxdepth(size_t depth) { maxdepth = depth; }
+
+/**
+ * settracer
+ * @param tracer records a span for every call from enterfn to leavefn, null
+ * to stop tracing
+ */
+void Memory::settracer(Tracer *tracer) { this->tracer = tracer; }
+
+void Memory::seterrors(std::ostream *errors) { this->errors = errors; }
 
 std::string Memory::getType(const std::string &var) const {
-  return variabletypes.top().at(var);
+  return get(var).typeName();
 }
 
-num Memory::strtonum(const std::string &number) const {
-  if (numexists(number)) {
-    return getnum(number);
-  }
-  std::stringstream ss(number);
-  num val;
-  ss >> val;
-  return val;
+/**
+ * checkmem
+ * @param name a defmem function
+ * @param call the arguments of the call
+ * @param result set to the remembered result on a hit
+ * @return true on a hit, a miss must be followed by insertmem or abandonmem
+ */
+bool Memory::checkmem(const std::string &name, const std::vector<Value> &call,
+                      Value &result) {
+  return memo->find(name, call, result);
 }
 
-bool Memory::strtobool(const std::string &val) const {
-  bool isVariable = boolexists(val);
-  auto isBoolean = [&](std::string value) -> bool {
-    if (boolexists(value)) {
-      return true;
-    }
-    return (value == "true" || value == "false" || value == "0" ||
-            value == "1");
-  };
-  if ((!isVariable) && !isBoolean(val)) {
-    std::cerr << "Calling strtobool on nonboolean value \"" << val << "\""
-              << std::endl;
-  }
-  if (isVariable) {
-    return getboolean(val);
-  }
-  return (val == "true" || val == "1");
+void Memory::insertmem(const std::string &name, const std::vector<Value> &call,
+                       const Value &result) {
+  memo->insert(name, call, result);
 }
 
-std::string Memory::strtostr(const std::string &var) const {
-  if (strexists(var)) {
-    return getstring(var);
-  } else {
-    return var;
-  }
+/**
+ * abandonmem- called when a call that missed fails before it has a result
+ */
+void Memory::abandonmem(const std::string &name,
+                        const std::vector<Value> &call) {
+  memo->abandon(name, call);
 }
 
-std::string Memory::strtolist(const std::string &val) const {
-  return listexists(val) ? getlist(val) : val;
+/**
+ * setmembudget
+ * @param total the most bytes all memoized results may take, 0 for no limit
+ * @param perfunction the most bytes the results of one defmem function may
+ * take, 0 for no limit
+ */
+void Memory::setmembudget(size_t total, size_t perfunction) {
+  memo->setbudget(total, perfunction);
 }
 
-std::string Memory::to_string(const num &value) const {
-  std::stringstream ss;
-  ss << value;
-  return ss.str();
+/**
+ * setmemwaiting
+ * @param wait if a thread missing on a call another thread is computing
+ * waits for that result rather than computing it too
+ */
+void Memory::setmemwaiting(bool wait) { memo->setwaiting(wait); }
+
+MemoStats Memory::memstats(const std::string &name) const {
+  return memo->stats(name);
 }
 
-std::string *Memory::checkmem(const std::string &name,
-                              const std::vector<std::string> &call) {
-  if (memvalues[name].count(call) == 0) {
-    return nullptr;
-  } else {
-    return &memvalues[name][call];
+MemoStats Memory::memstats() const { return memo->stats(); }
+
+std::vector<std::string> Memory::memfunctions() const {
+  return memo->functions();
+}
+
+/**
+ * setmemcache
+ * @param path a file that keeps defmem results between runs, results already
+ * in it are restored as the functions are defined
+ */
+void Memory::setmemcache(const std::string &path) {
+  memcache = std::make_unique<MemoCache>(path, *errors);
+}
+
+/**
+ * savememcache- writes the results of the defmem functions defined so far
+ * to the memo cache, if there is one
+ */
+void Memory::savememcache() {
+  if (!memcache) {
+    return;
+  }
+  for (const std::string &name : memcache->restored()) {
+    memcache->update(name, memo->entries(name));
   }
+  memcache->save();
 }
 
-void Memory::insertmem(const std::string &name,
-                       const std::vector<std::string> &call,
-                       const std::string &result) {
-  memvalues[name][call] = result;
+bool Memory::isBinding(const std::string &var) const {
+  const Value *value = findvar(var);
+  return value != nullptr && value->isFunction();
 }
 
 std::string Memory::getBinding(const std::string &var) const {
-  return functionbindings.top().at(var);
+  return get(var).asString();
 }
 
 bool Memory::libraryExists(const std::string &var) const {
   return libraries.count(var) != 0;
 }
 
-bool Memory::librayImported(const std::string &var) const {
-  return libraries.at(var);
+/**
+ * createnative- registers a C++ function
+ * @param name library.function, the library is made on first use
+ * @param types the type of every parameter
+ * @param body the function
+ */
+void Memory::createnative(const std::string &name,
+                          const std::vector<std::string> &types,
+                          Native body) {
+  const size_t dot = name.find('.');
+  if (dot == 0 || dot == std::string::npos || dot + 1 == name.length() ||
+      name.find('.', dot + 1) != std::string::npos ||
+      name.find_first_of(" \t()[]\"") != std::string::npos) {
+    throw Exception("Native function " + name +
+                    " must be named library.function");
+  }
+  for (const std::string &type : types) {
+    if (type != "num" && type != "string" && type != "boolean" &&
+        type != "list" && type != "fn") {
+      throw Exception("Type " + type + " does not exist");
+    }
+  }
+  if (!body) {
+    throw Exception("Native function " + name + " has no body");
+  }
+  if (functioninuse(name)) {
+    throw Exception("Unable to redefine \"" + name + "\"");
+  }
+  libraries.insert(name.substr(0, dot));
+  natives.emplace(name, std::make_shared<const NativeFunction>(
+      NativeFunction{name, types, std::move(body)}));
+  ++definitions;
 }
 
-void Memory::importLibrary(const std::string &var) { libraries.at(var) = true; }
-
-void Memory::loadLibraries() {}
+/**
+ * findnative
+ * @param name library.function
+ * @return the registered function, null if there is none
+ */
+const NativeFunction *Memory::findnative(const std::string &name) const {
+  auto native = natives.find(name);
+  return native != natives.end() ? native->second.get() : nullptr;
+}
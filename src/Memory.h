@@ -10,25 +10,33 @@
 #define MONET_MEMORY_H
 
 #include "Exception.h"
+#include "ConcurrentMemo.h"
+#include "MemoCache.h"
+#include "Native.h"
+#include "Node.h"
+#include "Parser.h"
+#include "Tracer.h"
+#include <iostream>
 #include <map>
+#include <memory>
 #include <set>
-#include <stack>
 #include <vector>
-#include <boost/multiprecision/mpfr.hpp>
 
-typedef  boost::multiprecision::number< boost::multiprecision::mpfr_float_backend<300>>  num;
 
 class Memory {
 public:
-  Memory();
+  explicit Memory(
+      std::shared_ptr<Symbols> symbols = std::make_shared<Symbols>());
+  void share(const Memory &parent);
+  const std::shared_ptr<Symbols> &symboltable() const;
+  size_t definitioncount() const;
   // getters
-  std::string get(const std::string &var) const;
-  std::string getstring(const std::string &var) const;
-  bool getboolean(const std::string &var) const;
-  num getnum(const std::string &var) const;
-  std::string getlist(const std::string &var) const;
+  Value get(const std::string &var) const;
+  const Value *find(Symbol symbol) const;
+  const Value *getslot(uint32_t slot) const;
 
-  std::vector<std::string> getfn(const std::string &var) const;
+  const Function &getfn(const std::string &var) const;
+  const Function *findfn(const std::string &name) const;
 
   // checks for functions
   bool functioninuse(const std::string &val) const;
@@ -36,74 +44,113 @@ public:
   bool isFunction(const std::string &val) const;
   bool isSubroutine(const std::string &val) const;
   bool isMem(const std::string &val) const;
+  bool isNative(const std::string &val) const;
 
   // creating functions
   void createfunction(const std::string &name,
-                      const std::vector<std::string> &code);
-  void createsub(const std::string &name, const std::vector<std::string> &code);
-  void createmem(const std::string &name, const std::vector<std::string> &code);
-
-  // creating primitives
-  void createboolean(const std::string &name, bool value);
-  void createnum(const std::string &name, num number);
-  void createstring(const std::string &name, const std::string &str);
-  void createlist(const std::string &name, const std::string &list);
-
-  // checks for primitives
-  bool boolexists(const std::string &var) const;
-  bool strexists(const std::string &var) const;
-  bool numexists(const std::string &var) const;
-  bool listexists(const std::string &var) const;
+                      std::shared_ptr<const Function> code);
+  void createsub(const std::string &name, std::shared_ptr<const Function> code);
+  void createmem(const std::string &name, std::shared_ptr<const Function> code);
+  void createnative(const std::string &name,
+                    const std::vector<std::string> &types, Native body);
+  const NativeFunction *findnative(const std::string &name) const;
+
+  // creating variables
+  void create(const std::string &name, const Value &value);
+  void create(Symbol symbol, const Value &value);
+
+  // checks for variables
   bool varexists(const std::string &var) const;
 
   // changing scope
   void enterfn();
-  void enterfn(const std::vector<std::string> &parameters,
-               const std::vector<std::string> &fndefinition);
+  void enterfn(const std::vector<Value> &parameters,
+               const Function &fndefinition);
+  void replacefn(const std::vector<Value> &parameters,
+                 const Function &fndefinition);
   void leavefn();
+  void leaveall();
+  Value convert(const std::string &type, const Value &value) const;
+  void setmaxdepth(size_t depth);
+  void settracer(Tracer *tracer);
+  void seterrors(std::ostream *errors);
 
   // memoize functions
-  std::string *checkmem(const std::string &name,
-                        const std::vector<std::string> &call);
-  void insertmem(const std::string &name, const std::vector<std::string> &call,
-                 const std::string &result);
+  bool checkmem(const std::string &name, const std::vector<Value> &call,
+                Value &result);
+  void insertmem(const std::string &name, const std::vector<Value> &call,
+                 const Value &result);
+  void abandonmem(const std::string &name, const std::vector<Value> &call);
+  void setmembudget(size_t total, size_t perfunction);
+  void setmemwaiting(bool wait);
+  MemoStats memstats(const std::string &name) const;
+  MemoStats memstats() const;
+  std::vector<std::string> memfunctions() const;
+  void setmemcache(const std::string &path);
+  void savememcache();
 
   // for high order functions
+  bool isBinding(const std::string &var) const;
   std::string getBinding(const std::string &var) const;
   std::string getType(const std::string &var) const;
 
   // For libraries
   bool libraryExists(const std::string &var) const;
-  bool librayImported(const std::string &var) const;
-  void importLibrary(const std::string &var);
 
 private:
-  num strtonum(const std::string &str) const;
-  bool strtobool(const std::string &str) const;
-  std::string strtostr(const std::string &str) const;
-  std::string strtolist(const std::string &str) const;
-  std::string to_string(const num &) const;
-  void loadLibraries();
-
-  std::stack<std::map<std::string, bool>> booleans;
-  std::stack<std::map<std::string, num>> nums;
-  std::stack<std::map<std::string, std::string>> strings;
-  std::stack<std::map<std::string, std::string>> lists;
-  std::map<std::string, std::vector<std::string>> functions;
-  std::map<std::string, std::vector<std::string>> subroutines;
-  std::map<std::string, std::vector<std::string>> mems;
-
-  std::map<std::string, std::map<std::vector<std::string>, std::string>>
-      memvalues;
-
-  std::set<std::string> reservedwords;
+  const Value *findvar(const std::string &var) const;
+
+  /**
+   * Frame- the variables of one function call
+   * Variables the function was resolved with live in its run of the slot
+   * stack, anything else, such as variables declared at the top level, is
+   * kept by symbol.
+   */
+  struct Frame {
+    const Layout *layout;
+    // index of the first slot of the frame in the slot stack
+    size_t base;
+    std::map<Symbol, Value> others;
+    // the function called, null for the top level
+    const Function *function;
+    // when the call started, only kept while tracing
+    uint64_t start;
+  };
+
+  // Both stacks keep their capacity, so once a program has reached its
+  // deepest call, entering and leaving functions does not allocate. fn
+  // parameters are stored as function values.
+  std::vector<Frame> frames;
+  std::vector<Value> slots;
+  // the most nested function calls, 0 for no limit
+  size_t maxdepth = 0;
+  // Definitions never change once made, calls refer to them in place
+  std::map<std::string, std::shared_ptr<const Function>> functions;
+  std::map<std::string, std::shared_ptr<const Function>> subroutines;
+  std::map<std::string, std::shared_ptr<const Function>> mems;
+
+  // shared with the workers of the parallel builtins
+  std::shared_ptr<ConcurrentMemo> memo;
+  // records the calls when tracing, owned by the interpreter
+  Tracer *tracer = nullptr;
+  // where type warnings go
+  std::ostream *errors = &std::cerr;
+  // only set when results are kept between runs
+  std::unique_ptr<MemoCache> memcache;
+
+  // the names of the interpreter, shared with its workers
+  std::shared_ptr<Symbols> symbols;
+  // reads list parameters that arrive as text
+  Parser parser;
+
   std::set<std::string> functionnamespace;
   std::set<std::string> subroutinenamespace;
   std::set<std::string> memnamespace;
-  std::map<std::string, bool> libraries;
-
-  std::stack<std::map<std::string, std::string>> variabletypes;
-  std::stack<std::map<std::string, std::string>> functionbindings;
+  // the libraries native functions were registered under
+  std::set<std::string> libraries;
+  std::map<std::string, std::shared_ptr<const NativeFunction>> natives;
+  // counts the definitions above, tells a worker its copies are out of date
+  size_t definitions = 0;
 };
 
 #endif // MONET_MEMORY_H
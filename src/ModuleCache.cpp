@@ -0,0 +1,370 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: ModuleCache.cpp
+ */
+
+#include "ModuleCache.h"
+#include "MemoCache.h"
+#include "Source.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+const std::string HEADER = "monet-module 2\n";
+
+char kindLetter(FunctionKind kind) {
+  switch (kind) {
+  case FunctionKind::Memoized:
+    return 'm';
+  case FunctionKind::Subroutine:
+    return 's';
+  default:
+    return 'f';
+  }
+}
+} // namespace
+
+/**
+ * Constructor
+ * @param directory where the parsed files are kept, it is created on the
+ * first save if it does not exist
+ * @param errors where problems with the directory are reported
+ * @param symbols the table of the interpreter the files are loaded into
+ */
+ModuleCache::ModuleCache(const std::string &directory, std::ostream &errors,
+                         Symbols &symbols)
+    : directory(directory), errors(&errors), symbols(&symbols),
+      parser(symbols) {}
+
+/**
+ * restore
+ * @param source the text of a program file
+ * @param statements set to the parsed statements of the file if they are
+ * kept
+ * @return false if the file has not been kept, its entry is damaged or was
+ * made for another text filed under the same hash, it has to be parsed then
+ */
+bool ModuleCache::restore(std::string_view source,
+                          std::vector<Node> &statements) const {
+  const Source entry(file(source));
+  const std::string_view in = entry.text();
+  const std::string length = std::to_string(source.length()) + "\n";
+  if (in.compare(0, HEADER.length(), HEADER) != 0 ||
+      in.compare(HEADER.length(), length.length(), length) != 0) {
+    return false;
+  }
+  size_t pos = HEADER.length() + length.length();
+  // the entry keeps the whole text it was made from
+  if (in.length() - pos < source.length() ||
+      in.compare(pos, source.length(), source) != 0) {
+    return false;
+  }
+  pos += source.length();
+  uint64_t count;
+  if (!decodeCount(in, pos, count)) {
+    return false;
+  }
+  std::vector<Node> restored(count);
+  for (Node &statement : restored) {
+    if (!decode(in, pos, statement, source, false)) {
+      return false;
+    }
+  }
+  if (pos != in.length()) {
+    return false;
+  }
+  statements = std::move(restored);
+  return true;
+}
+
+/**
+ * save- keeps the parsed statements of a file, replacing what was kept for
+ * the same text
+ * @param source the text of the file
+ * @param statements what the parser made of it
+ */
+void ModuleCache::save(std::string_view source,
+                       const std::vector<Node> &statements) const {
+  std::string out = HEADER + std::to_string(source.length()) + "\n";
+  out += source;
+  out += std::to_string(statements.size()) + ":";
+  size_t cursor = 0;
+  for (const Node &statement : statements) {
+    encode(statement, out, source, cursor);
+  }
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  const std::string path = file(source);
+  // written beside the entry and renamed over it, so a reader never sees
+  // half a file, even when runs save the same file at once
+  const std::string temp =
+      path + "." +
+      std::to_string(
+          std::chrono::steady_clock::now().time_since_epoch().count()) +
+      ".tmp";
+  std::ofstream entry(temp, std::ios::binary | std::ios::trunc);
+  entry << out;
+  entry.close();
+  if (!entry || std::rename(temp.c_str(), path.c_str()) != 0) {
+    std::remove(temp.c_str());
+    *errors << "Unable to write module cache " << path << std::endl;
+  }
+}
+
+/**
+ * file
+ * @param source the text of a program file
+ * @return the path of its entry
+ */
+std::string ModuleCache::file(std::string_view source) const {
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx",
+                static_cast<unsigned long long>(MemoCache::hash(source)));
+  return directory + "/" + name + ".mod";
+}
+
+/**
+ * encode
+ * @param node a parsed node
+ * @param out where the text goes, a letter for the kind of node followed by
+ * its length prefixed text and its children
+ * @param parent the text of the node it is part of, the file for statements
+ * @param cursor where the previous part was found in parent
+ */
+void ModuleCache::encode(const Node &node, std::string &out,
+                         std::string_view parent, size_t &cursor) {
+  switch (node.type) {
+  case NodeType::Word:
+    out += "w";
+    encodeText(node.text, out);
+    return;
+  case NodeType::Literal:
+    out += node.value.isNumber() ? "n" : node.value.isBoolean() ? "b" : "s";
+    encodeText(node.text, out);
+    return;
+  case NodeType::List:
+  case NodeType::Expression: {
+    out += node.type == NodeType::List ? "l" : "e";
+    encodeText(node.text, out, parent, cursor);
+    out += std::to_string(node.children.size()) + ":";
+    size_t inner = 0;
+    for (const Node &child : node.children) {
+      encode(child, out, node.text, inner);
+    }
+    return;
+  }
+  case NodeType::Definition: {
+    const Function &function = *node.function;
+    out += "d";
+    out += kindLetter(function.kind);
+    encodeText(function.name, out);
+    encodeText(function.returntype, out);
+    out += std::to_string(function.parameters.size()) + ":";
+    for (const Parameter &parameter : function.parameters) {
+      encodeText(parameter.type, out);
+      encodeText(parameter.name, out);
+    }
+    encodeText(function.source, out, parent, cursor);
+    out += std::to_string(function.body.size()) + ":";
+    size_t line = 0;
+    for (const Node &statement : function.body) {
+      encode(statement, out, function.source, line);
+    }
+    return;
+  }
+  }
+}
+
+void ModuleCache::encodeText(std::string_view text, std::string &out) {
+  out += std::to_string(text.length()) + ":";
+  out += text;
+}
+
+/**
+ * encodeText
+ * @param text the text of an expression, list or function
+ * @param out where the text goes
+ * @param parent the text of the node it is part of
+ * @param cursor where the text of the previous part ended in parent
+ * @return the text as where it is in parent when it is found there, which
+ * keeps nested expressions from repeating the text of the outer ones
+ */
+void ModuleCache::encodeText(std::string_view text, std::string &out,
+                             std::string_view parent, size_t &cursor) {
+  const size_t at = text.empty() ? std::string_view::npos
+                                 : parent.find(text, cursor);
+  if (at == std::string_view::npos) {
+    encodeText(text, out);
+    return;
+  }
+  out += "@" + std::to_string(at) + ":" + std::to_string(text.length()) + ":";
+  cursor = at + text.length();
+}
+
+/**
+ * decode
+ * @param in the entry
+ * @param pos where the node starts, moved past it
+ * @param node set to the node as the parser made it
+ * @param inExpression whether the node is a word of an expression, those
+ * are interned and resolved to their builtin
+ * @return false if the entry is damaged
+ */
+bool ModuleCache::decode(std::string_view in, size_t &pos, Node &node,
+                         std::string_view parent, bool inExpression) const {
+  if (pos == in.length()) {
+    return false;
+  }
+  const char kind = in[pos++];
+  if (kind == 'd') {
+    return decodeFunction(in, pos, node, parent);
+  }
+  if (!decodeText(in, pos, node.text, parent)) {
+    return false;
+  }
+  switch (kind) {
+  case 'w':
+    node.type = NodeType::Word;
+    if (inExpression) {
+      node.symbol = symbols->intern(node.text);
+      node.builtin = Builtins::find(node.text);
+    }
+    return true;
+  case 'n':
+    node.type = NodeType::Literal;
+    node.value = Value::number(num::parse(node.text));
+    return true;
+  case 'b':
+    node.type = NodeType::Literal;
+    node.value = Value::boolean(node.text == "true");
+    return true;
+  case 's':
+    node.type = NodeType::Literal;
+    node.value = Value::string(node.text);
+    return true;
+  case 'l':
+  case 'e': {
+    node.type = kind == 'l' ? NodeType::List : NodeType::Expression;
+    uint64_t count;
+    if (!decodeCount(in, pos, count) || count > in.length() - pos) {
+      return false;
+    }
+    node.children.resize(count);
+    for (Node &child : node.children) {
+      if (!decode(in, pos, child, node.text, kind == 'e')) {
+        return false;
+      }
+    }
+    if (kind == 'l') {
+      node.value = parser.listValue(node.children);
+    }
+    return true;
+  }
+  }
+  return false;
+}
+
+bool ModuleCache::decodeFunction(std::string_view in, size_t &pos,
+                                 Node &node, std::string_view parent) const {
+  if (pos == in.length()) {
+    return false;
+  }
+  auto function = std::make_shared<Function>();
+  switch (in[pos++]) {
+  case 'f':
+    function->kind = FunctionKind::Function;
+    break;
+  case 'm':
+    function->kind = FunctionKind::Memoized;
+    break;
+  case 's':
+    function->kind = FunctionKind::Subroutine;
+    break;
+  default:
+    return false;
+  }
+  uint64_t count;
+  if (!decodeText(in, pos, function->name) ||
+      !decodeText(in, pos, function->returntype) ||
+      !decodeCount(in, pos, count) || count > in.length() - pos) {
+    return false;
+  }
+  function->parameters.resize(count);
+  for (Parameter &parameter : function->parameters) {
+    if (!decodeText(in, pos, parameter.type) ||
+        !decodeText(in, pos, parameter.name)) {
+      return false;
+    }
+    parameter.symbol = symbols->intern(parameter.name);
+  }
+  if (!decodeText(in, pos, function->source, parent) ||
+      !decodeCount(in, pos, count) || count > in.length() - pos) {
+    return false;
+  }
+  function->body.resize(count);
+  for (Node &statement : function->body) {
+    if (!decode(in, pos, statement, function->source, false)) {
+      return false;
+    }
+  }
+  node.type = NodeType::Definition;
+  node.text = function->source;
+  node.function = std::move(function);
+  return true;
+}
+
+/**
+ * decodeCount
+ * @param in the entry
+ * @param pos where the count starts, moved past the colon that ends it
+ * @param count the count that was read
+ * @return false if the count is damaged
+ */
+bool ModuleCache::decodeCount(std::string_view in, size_t &pos,
+                              uint64_t &count) {
+  const size_t start = pos;
+  count = 0;
+  while (pos < in.length() && in[pos] >= '0' && in[pos] <= '9' &&
+         pos - start < 19) {
+    count = count * 10 + (in[pos++] - '0');
+  }
+  if (pos == start || pos == in.length() || in[pos] != ':') {
+    return false;
+  }
+  ++pos;
+  return true;
+}
+
+/**
+ * decodeText
+ * @param in the entry
+ * @param pos where the text starts, moved past it
+ * @param text the text that was read
+ * @param parent the text of the node it is part of, text kept as where it is
+ * in parent is copied from there
+ * @return false if the text is damaged
+ */
+bool ModuleCache::decodeText(std::string_view in, size_t &pos,
+                             std::string &text, std::string_view parent) {
+  uint64_t at, length;
+  if (pos < in.length() && in[pos] == '@') {
+    ++pos;
+    if (!decodeCount(in, pos, at) || !decodeCount(in, pos, length) ||
+        at > parent.length() || parent.length() - at < length) {
+      return false;
+    }
+    text = std::string(parent.substr(at, length));
+    return true;
+  }
+  if (!decodeCount(in, pos, length) || in.length() - pos < length) {
+    return false;
+  }
+  text = std::string(in.substr(pos, length));
+  pos += length;
+  return true;
+}
@@ -0,0 +1,60 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: ModuleCache.h
+ */
+
+#ifndef MONET_MODULECACHE_H
+#define MONET_MODULECACHE_H
+
+#include "Node.h"
+#include "Parser.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * ModuleCache- parsed program files kept in a directory between runs
+ * A file is filed under a hash of its text, so any edit makes it parsed
+ * again and files with the same text share one entry. An entry keeps the
+ * text it was made from and is only used for that same text. Entries are
+ * read back into the same statements the parser would make, without parsing.
+ */
+class ModuleCache {
+public:
+  ModuleCache(const std::string &directory, std::ostream &errors,
+              Symbols &symbols);
+
+  bool restore(std::string_view source, std::vector<Node> &statements) const;
+  void save(std::string_view source,
+            const std::vector<Node> &statements) const;
+
+private:
+  std::string file(std::string_view source) const;
+  static void encode(const Node &node, std::string &out,
+                     std::string_view parent, size_t &cursor);
+  static void encodeText(std::string_view text, std::string &out);
+  static void encodeText(std::string_view text, std::string &out,
+                         std::string_view parent, size_t &cursor);
+  bool decode(std::string_view in, size_t &pos, Node &node,
+              std::string_view parent, bool inExpression) const;
+  bool decodeFunction(std::string_view in, size_t &pos, Node &node,
+                      std::string_view parent) const;
+  static bool decodeCount(std::string_view in, size_t &pos, uint64_t &count);
+  static bool decodeText(std::string_view in, size_t &pos, std::string &text,
+                         std::string_view parent = std::string_view());
+
+  std::string directory;
+  // where problems with the directory are reported
+  std::ostream *errors;
+  // the words of restored expressions are interned here
+  Symbols *symbols;
+  // builds the values of list nodes
+  Parser parser;
+};
+
+#endif // MONET_MODULECACHE_H
@@ -0,0 +1,35 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Native.h
+ */
+
+#ifndef MONET_NATIVE_H
+#define MONET_NATIVE_H
+
+#include "Value.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Native- the body of a function written in C++
+ * The arguments arrive converted to the types the function declares, so a
+ * num parameter is read in place with asNumber, a list one with asList and
+ * so on, without going through text.
+ */
+typedef std::function<Value(const std::vector<Value> &)> Native;
+
+/**
+ * NativeFunction- a C++ function Monet code calls as library.function
+ */
+struct NativeFunction {
+  std::string name;
+  // one of num, string, boolean, list or fn for every parameter
+  std::vector<std::string> types;
+  Native body;
+};
+
+#endif // MONET_NATIVE_H
@@ -0,0 +1,100 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Node.h
+ */
+
+#ifndef MONET_NODE_H
+#define MONET_NODE_H
+
+#include "Builtin.h"
+#include "Symbol.h"
+#include "Value.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Chunk;
+struct Function;
+
+enum class NodeType { Word, Literal, List, Expression, Definition };
+
+// the slot of a word that is not a variable of its function
+const uint32_t NO_SLOT = UINT32_MAX;
+
+/**
+ * Node- one element of a parsed program
+ * Words and lists are leaves that hold their text, literals also hold the
+ * number, boolean or string they stand for. Expressions hold their words as
+ * children, the first child being the command. Definitions hold the function
+ * they declare. Words in expressions are interned and resolved to the builtin
+ * they name, and words naming a variable of the enclosing function know its
+ * frame slot. Statements, expressions in lists and lists in expressions keep
+ * their source text, expressions nested in an expression and lists nested in
+ * a list are never printed and keep none.
+ */
+struct Node {
+  NodeType type = NodeType::Word;
+  std::string text;
+  Symbol symbol = 0;
+  Builtin builtin = Builtin::None;
+  uint32_t slot = NO_SLOT;
+  Value value;
+  std::vector<Node> children;
+  std::shared_ptr<const Function> function;
+};
+
+enum class FunctionKind { Function, Memoized, Subroutine };
+
+struct Parameter {
+  std::string type;
+  std::string name;
+  Symbol symbol;
+};
+
+/**
+ * Layout- the variables of a function frame, parameters take the first
+ * slots and the variables the body declares follow
+ */
+struct Layout {
+  std::vector<Symbol> names;
+
+  uint32_t find(Symbol symbol) const {
+    for (uint32_t slot = 0; slot < names.size(); ++slot) {
+      if (names[slot] == symbol) {
+        return slot;
+      }
+    }
+    return NO_SLOT;
+  }
+
+  uint32_t add(Symbol symbol) {
+    uint32_t slot = find(symbol);
+    if (slot == NO_SLOT) {
+      names.push_back(symbol);
+      slot = names.size() - 1;
+    }
+    return slot;
+  }
+};
+
+/**
+ * Function- a parsed define, defmem or subroutine
+ */
+struct Function {
+  FunctionKind kind = FunctionKind::Function;
+  std::string name;
+  std::string returntype;
+  std::vector<Parameter> parameters;
+  std::vector<Node> body;
+  // the text of the definition, from the header to its end
+  std::string source;
+  // resolved when the function is defined, subroutines use their caller's
+  Layout layout;
+  // compiled body, only set when running on the vm
+  std::shared_ptr<const Chunk> bytecode;
+};
+
+#endif // MONET_NODE_H
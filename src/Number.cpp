@@ -0,0 +1,214 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Number.cpp
+ */
+
+#include "Number.h"
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <sstream>
+
+namespace {
+const int64_t smallest = std::numeric_limits<int64_t>::min();
+const int64_t largest = std::numeric_limits<int64_t>::max();
+// operands below this magnitude cannot overflow when multiplied
+const int64_t halfwidth = int64_t(1) << 31;
+} // namespace
+
+Number::Number() : value(int64_t(0)) {}
+
+Number::Number(int64_t value) : value(value) {}
+
+Number::Number(const bignum &value) : value(value) {}
+
+bool Number::isSmall() const { return value.index() == 0; }
+
+bignum Number::big() const {
+  if (isSmall()) {
+    return bignum(std::get<int64_t>(value));
+  }
+  return std::get<bignum>(value);
+}
+
+/**
+ * truncate
+ * @return the whole part of the number, saturated to the int64 range
+ */
+int64_t Number::truncate() const {
+  if (isSmall()) {
+    return std::get<int64_t>(value);
+  }
+  const bignum &x = std::get<bignum>(value);
+  if (x <= smallest) {
+    return smallest;
+  } else if (x >= largest) {
+    return largest;
+  }
+  return trunc(x).convert_to<int64_t>();
+}
+
+Number Number::operator+(const Number &other) const {
+  if (isSmall() && other.isSmall()) {
+    int64_t x = std::get<int64_t>(value);
+    int64_t y = std::get<int64_t>(other.value);
+    if ((y > 0 && x <= largest - y) || (y <= 0 && x >= smallest - y)) {
+      return Number(x + y);
+    }
+  }
+  return demote(big() + other.big());
+}
+
+Number Number::operator-(const Number &other) const {
+  if (isSmall() && other.isSmall()) {
+    int64_t x = std::get<int64_t>(value);
+    int64_t y = std::get<int64_t>(other.value);
+    if ((y > 0 && x >= smallest + y) || (y <= 0 && x <= largest + y)) {
+      return Number(x - y);
+    }
+  }
+  return demote(big() - other.big());
+}
+
+Number Number::operator*(const Number &other) const {
+  if (isSmall() && other.isSmall()) {
+    int64_t x = std::get<int64_t>(value);
+    int64_t y = std::get<int64_t>(other.value);
+    if (x > -halfwidth && x < halfwidth && y > -halfwidth && y < halfwidth) {
+      return Number(x * y);
+    }
+  }
+  return demote(big() * other.big());
+}
+
+/**
+ * operator/- the caller is responsible for rejecting a zero divisor
+ */
+Number Number::operator/(const Number &other) const {
+  if (isSmall() && other.isSmall()) {
+    int64_t x = std::get<int64_t>(value);
+    int64_t y = std::get<int64_t>(other.value);
+    if (y != 0 && !(x == smallest && y == -1) && x % y == 0) {
+      return Number(x / y);
+    }
+  }
+  return demote(big() / other.big());
+}
+
+Number &Number::operator+=(const Number &other) {
+  return *this = *this + other;
+}
+
+Number &Number::operator-=(const Number &other) {
+  return *this = *this - other;
+}
+
+Number &Number::operator*=(const Number &other) {
+  return *this = *this * other;
+}
+
+Number &Number::operator/=(const Number &other) {
+  return *this = *this / other;
+}
+
+bool Number::operator==(const Number &other) const {
+  if (isSmall() && other.isSmall()) {
+    return std::get<int64_t>(value) == std::get<int64_t>(other.value);
+  }
+  return big() == other.big();
+}
+
+bool Number::operator!=(const Number &other) const {
+  return !(*this == other);
+}
+
+bool Number::operator<(const Number &other) const {
+  if (isSmall() && other.isSmall()) {
+    return std::get<int64_t>(value) < std::get<int64_t>(other.value);
+  }
+  return big() < other.big();
+}
+
+bool Number::operator>(const Number &other) const { return other < *this; }
+
+/**
+ * str
+ * @return the number as it is printed, whole numbers have no decimal point
+ */
+std::string Number::str() const {
+  if (isSmall()) {
+    return std::to_string(std::get<int64_t>(value));
+  }
+  const bignum &x = std::get<bignum>(value);
+  if (abs(fmod(x, 1)) < .000001) {
+    bignum whole = trunc(x);
+    if (whole >= smallest && whole <= largest) {
+      return std::to_string(whole.convert_to<int64_t>());
+    }
+    std::string digits = whole.str(0, std::ios_base::fixed);
+    return digits.substr(0, digits.find('.'));
+  }
+  std::stringstream ss;
+  ss << x;
+  return ss.str();
+}
+
+std::string Number::repr() const {
+  if (isSmall()) {
+    return std::to_string(std::get<int64_t>(value));
+  }
+  return std::get<bignum>(value).str(0, std::ios_base::scientific);
+}
+
+/**
+ * hash
+ * @return a hash that is the same for equal numbers
+ */
+size_t Number::hash() const {
+  if (isSmall()) {
+    return std::hash<int64_t>()(std::get<int64_t>(value));
+  }
+  const bignum &x = std::get<bignum>(value);
+  if (x >= smallest && x <= largest && trunc(x) == x) {
+    return std::hash<int64_t>()(x.convert_to<int64_t>());
+  }
+  return std::hash<std::string>()(x.str());
+}
+
+/**
+ * parse
+ * @param text a number literal, see Value::isNumeric
+ * @return the number, as a machine integer when it is whole and fits
+ */
+Number Number::parse(const std::string &text) {
+  size_t x = (!text.empty() && text[0] == '-') ? 1 : 0;
+  // 18 digits always fit in an int64
+  if (text.length() > x && text.length() - x <= 18) {
+    int64_t result = 0;
+    for (; x < text.length() && isdigit(text[x]); ++x) {
+      result = result * 10 + (text[x] - '0');
+    }
+    if (x == text.length()) {
+      return Number(text[0] == '-' ? -result : result);
+    }
+  }
+  std::stringstream ss(text);
+  bignum result;
+  ss >> result;
+  return demote(result);
+}
+
+/**
+ * demote
+ * @param value a result computed by the mpfr backend
+ * @return the same number, as a machine integer if it is whole and fits
+ */
+Number Number::demote(const bignum &value) {
+  if (value >= smallest && value <= largest && trunc(value) == value) {
+    return Number(value.convert_to<int64_t>());
+  }
+  return Number(value);
+}
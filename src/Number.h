@@ -0,0 +1,64 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Number.h
+ */
+
+#ifndef MONET_NUMBER_H
+#define MONET_NUMBER_H
+
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <boost/multiprecision/mpfr.hpp>
+
+typedef  boost::multiprecision::number< boost::multiprecision::mpfr_float_backend<300>>  bignum;
+
+/**
+ * Number- a Monet num
+ * Whole numbers are kept as machine integers while they fit. Anything that
+ * overflows, and anything with a fractional part, is promoted to the 300
+ * digit mpfr backend, and whole results that fit again are demoted.
+ */
+class Number {
+public:
+  Number();
+  Number(int64_t value);
+  Number(const bignum &value);
+
+  // true while the number is held as a machine integer
+  bool isSmall() const;
+  bignum big() const;
+  int64_t truncate() const;
+
+  Number operator+(const Number &other) const;
+  Number operator-(const Number &other) const;
+  Number operator*(const Number &other) const;
+  Number operator/(const Number &other) const;
+  Number &operator+=(const Number &other);
+  Number &operator-=(const Number &other);
+  Number &operator*=(const Number &other);
+  Number &operator/=(const Number &other);
+
+  bool operator==(const Number &other) const;
+  bool operator!=(const Number &other) const;
+  bool operator<(const Number &other) const;
+  bool operator>(const Number &other) const;
+
+  std::string str() const;
+  // text that parses back to the same number
+  std::string repr() const;
+  size_t hash() const;
+  static Number parse(const std::string &text);
+
+private:
+  static Number demote(const bignum &value);
+
+  std::variant<int64_t, bignum> value;
+};
+
+typedef Number num;
+
+#endif // MONET_NUMBER_H
@@ -0,0 +1,571 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Parser.cpp
+ */
+
+#include "Parser.h"
+#include <cctype>
+#include <cstring>
+
+/**
+ * Constructor
+ * @param symbols the table the words of parsed expressions are interned in
+ */
+Parser::Parser(Symbols &symbols) : symbols(&symbols) {}
+
+/**
+ * parse function- turns a program into statements in one pass
+ * @param source the source code, lines end with a newline
+ * @return the top level statements of the program, function declarations
+ * included
+ * Lines and words are read in place, only the text nodes keep is copied.
+ */
+std::vector<Node> Parser::parse(std::string_view source) const {
+  std::vector<Node> program;
+  std::vector<std::string_view> definition;
+  std::vector<Token> tokens;
+  bool inFunction = false;
+  size_t pos = 0;
+  while (pos < source.length()) {
+    const char *newline = static_cast<const char *>(
+        std::memchr(source.data() + pos, '\n', source.length() - pos));
+    const size_t end =
+        newline != nullptr ? newline - source.data() : source.length();
+    const std::string_view line = source.substr(pos, end - pos);
+    pos = end + 1;
+    // Function declarations are kept together until their end
+    if (!inFunction && startsDefinition(line)) {
+      inFunction = true;
+    }
+    if (inFunction) {
+      if (endsDefinition(line)) {
+        inFunction = false;
+        program.push_back(parseDefinition(definition, tokens));
+        definition.clear();
+      } else {
+        definition.push_back(line);
+      }
+      continue;
+    }
+    Node statement = parseStatement(line, tokens);
+    if (!statement.children.empty()) {
+      program.push_back(std::move(statement));
+    }
+  }
+  if (inFunction) {
+    throw Exception("Missing " + FUNCTION_END_NAME + " for \"" +
+                    std::string(definition[0]) + "\"");
+  }
+  return program;
+}
+
+/**
+ * parse function
+ * @param lines the source code, one line per entry
+ * @return the top level statements of the lines
+ */
+std::vector<Node> Parser::parse(const std::vector<std::string> &lines) const {
+  std::string source;
+  for (const std::string &line : lines) {
+    source += line;
+    source += '\n';
+  }
+  return parse(std::string_view(source));
+}
+
+/**
+ * parseStatement
+ * @param line one line of code
+ * @param tokens room for the tokens of the line
+ * @return the line as an expression, comments and empty lines have no
+ * children
+ */
+Node Parser::parseStatement(std::string_view line,
+                            std::vector<Token> &tokens) const {
+  Node statement;
+  size_t at = 0;
+  if (tokenize(line, tokens)) {
+    statement = buildExpression(tokens, at, line, true);
+  } else {
+    statement = parseExpression(line, true);
+  }
+  if (!statement.children.empty() &&
+      statement.children[0].type == NodeType::Word &&
+      statement.children[0].text.compare(0, 2, "//") == 0) {
+    // this is a comment
+    statement.children.clear();
+  }
+  return statement;
+}
+
+/**
+ * tokenize- reads a line once into its words and brackets
+ * @param line one line of code
+ * @param tokens set to the words of the line and the brackets of the
+ * expressions and lists in it, in order
+ * @return false when the brackets or quotes of the line do not match up, the
+ * line is then rescanned word by word to keep how such lines always parsed
+ */
+bool Parser::tokenize(std::string_view line,
+                      std::vector<Token> &tokens) const {
+  tokens.clear();
+  // the opening brackets that are not closed yet
+  std::vector<size_t> open;
+  size_t pos = 0;
+  while (true) {
+    const bool inList =
+        !open.empty() && tokens[open.back()].kind == TokenKind::OpenList;
+    const char closer = inList ? ']' : ')';
+    // list elements are split by any number of spaces
+    while (inList && pos < line.length() && line[pos] == ' ') {
+      ++pos;
+    }
+    if (pos == line.length()) {
+      return open.empty();
+    }
+    const char c = line[pos];
+    if (!open.empty() && c == closer) {
+      Token &opening = tokens[open.back()];
+      const size_t start = opening.text.data() - line.data();
+      opening.text = inList ? line.substr(start, pos + 1 - start)
+                            : line.substr(start + 1, pos - start - 1);
+      tokens.push_back(Token{inList ? TokenKind::CloseList : TokenKind::Close,
+                             std::string_view()});
+      open.pop_back();
+      ++pos;
+      // what encloses it has to go on with a new word or end there too
+      if (pos < line.length() && line[pos] == ' ') {
+        ++pos;
+      } else if (pos < line.length() &&
+                 (open.empty() ||
+                  line[pos] != (tokens[open.back()].kind == TokenKind::OpenList
+                                    ? ']'
+                                    : ')'))) {
+        return false;
+      }
+      continue;
+    }
+    if (c == '(' || c == '[') {
+      open.push_back(tokens.size());
+      tokens.push_back(Token{c == '(' ? TokenKind::Open : TokenKind::OpenList,
+                             line.substr(pos, 0)});
+      ++pos;
+      continue;
+    }
+    const size_t start = pos;
+    size_t end = line.length();
+    bool instr = false;
+    int inparens = 0;
+    int inlist = 0;
+    for (; pos < line.length(); ++pos) {
+      const char d = line[pos];
+      if (d == closer && !open.empty() && !instr && inparens == 0 &&
+          inlist == 0) {
+        end = pos;
+        break;
+      }
+      if (d == '"') {
+        instr = !instr;
+      } else if (!instr) {
+        inparens += (d == '(') - (d == ')');
+        inlist += (d == '[') - (d == ']');
+      }
+      if (inparens < 0 || inlist < 0) {
+        return false;
+      }
+      if (d == ' ' && pos != start && !instr && inparens == 0 &&
+          inlist == 0) {
+        end = pos++;
+        break;
+      }
+    }
+    if (instr || inparens != 0 || inlist != 0) {
+      return false;
+    }
+    // a space that starts a word is kept, a word of just that is dropped
+    const std::string_view word = line.substr(start, end - start);
+    if (word != " ") {
+      tokens.push_back(Token{TokenKind::Word, word});
+    }
+  }
+}
+
+/**
+ * buildExpression
+ * @param tokens the tokens of a line
+ * @param at the token after the opening bracket, moved past the closing one
+ * @param text the text of the expression without surrounding parenthesis
+ * @param keepText whether the node keeps that text
+ * @return an expression node whose children are the words of the text
+ */
+Node Parser::buildExpression(const std::vector<Token> &tokens, size_t &at,
+                             std::string_view text, bool keepText) const {
+  Node expression;
+  expression.type = NodeType::Expression;
+  if (keepText) {
+    expression.text = std::string(text);
+  }
+  while (at < tokens.size()) {
+    const Token &token = tokens[at++];
+    if (token.kind == TokenKind::Close) {
+      break;
+    } else if (token.kind == TokenKind::Open) {
+      expression.children.push_back(
+          buildExpression(tokens, at, token.text, false));
+    } else if (token.kind == TokenKind::OpenList) {
+      expression.children.push_back(buildList(tokens, at, token.text, true));
+    } else {
+      expression.children.push_back(leaf(lowered(token.text)));
+      Node &child = expression.children.back();
+      if (child.type == NodeType::Word) {
+        child.symbol = symbols->intern(child.text);
+        child.builtin = Builtins::find(child.text);
+      }
+    }
+  }
+  return expression;
+}
+
+/**
+ * buildList
+ * @param tokens the tokens of a line
+ * @param at the token after the opening bracket, moved past the closing one
+ * @param text the text of the list with its brackets
+ * @param keepText whether the node keeps that text
+ * @return a list node whose children are the elements and whose value is
+ * the list itself
+ */
+Node Parser::buildList(const std::vector<Token> &tokens, size_t &at,
+                       std::string_view text, bool keepText) const {
+  Node list;
+  list.type = NodeType::List;
+  if (keepText) {
+    list.text = std::string(text);
+  }
+  while (at < tokens.size()) {
+    const Token &token = tokens[at++];
+    if (token.kind == TokenKind::CloseList) {
+      break;
+    } else if (token.kind == TokenKind::Open) {
+      list.children.push_back(buildExpression(tokens, at, token.text, true));
+    } else if (token.kind == TokenKind::OpenList) {
+      list.children.push_back(buildList(tokens, at, token.text, false));
+    } else {
+      list.children.push_back(leaf(std::string(token.text)));
+    }
+  }
+  list.value = listValue(list.children);
+  return list;
+}
+
+/**
+ * parseExpression- rescans an expression whose brackets do not match up
+ * @param source the expression without surrounding parenthesis
+ * @param keepText whether the node keeps the source
+ * @return an expression node whose children are the words of the source
+ */
+Node Parser::parseExpression(std::string_view source, bool keepText) const {
+  Node expression;
+  expression.type = NodeType::Expression;
+  if (keepText) {
+    expression.text = std::string(source);
+  }
+  size_t pos = 0;
+  std::string word;
+  while (nextWord(source, pos, word)) {
+    expression.children.push_back(parseWord(word, false));
+    Node &child = expression.children.back();
+    if (child.type == NodeType::Word) {
+      child.symbol = symbols->intern(word);
+      child.builtin = Builtins::find(word);
+    }
+  }
+  return expression;
+}
+
+Node Parser::parseWord(std::string_view word, bool inList) const {
+  const char first = word[0];
+  const char last = word[word.length() - 1];
+  if (word.length() >= 2 && first == '(' && last == ')') {
+    return parseExpression(word.substr(1, word.length() - 2), inList);
+  } else if (word.length() >= 2 && first == '[' && last == ']') {
+    return parseList(word, !inList);
+  }
+  return leaf(std::string(word));
+}
+
+/**
+ * parseList
+ * @param word a bracketed list such as [1 2 [3 4]]
+ * @return a list node whose children are the elements and whose value is
+ * the list itself
+ */
+Node Parser::parseList(std::string_view word) const {
+  std::vector<Token> tokens;
+  if (tokenize(word, tokens) && !tokens.empty() &&
+      tokens[0].kind == TokenKind::OpenList) {
+    size_t at = 1;
+    Node list = buildList(tokens, at, tokens[0].text, true);
+    if (at == tokens.size()) {
+      return list;
+    }
+  }
+  return parseList(word, true);
+}
+
+Node Parser::parseList(std::string_view word, bool keepText) const {
+  Node list;
+  list.type = NodeType::List;
+  if (keepText) {
+    list.text = std::string(word);
+  }
+  for (std::string_view element :
+       listElements(word.substr(1, word.length() - 2))) {
+    list.children.push_back(parseWord(element, true));
+  }
+  list.value = listValue(list.children);
+  return list;
+}
+
+/**
+ * leaf
+ * @param word a word that is not an expression or list
+ * @return the string, number or boolean literal it spells, or the word
+ */
+Node Parser::leaf(std::string word) const {
+  Node node;
+  if (word.length() >= 2 && word[0] == '"' && word[word.length() - 1] == '"') {
+    node.type = NodeType::Literal;
+    node.text = word.substr(1, word.length() - 2);
+    node.value = Value::string(node.text);
+    return node;
+  }
+  node.text = std::move(word);
+  if (Value::isNumeric(node.text)) {
+    node.type = NodeType::Literal;
+    node.value = Value::number(num::parse(node.text));
+  } else if (node.text == "true" || node.text == "false") {
+    node.type = NodeType::Literal;
+    node.value = Value::boolean(node.text == "true");
+  } else {
+    node.type = NodeType::Word;
+  }
+  return node;
+}
+
+/**
+ * lowered
+ * @param word a word of an expression
+ * @return the word lowercased outside strings, parenthesis and lists
+ */
+std::string Parser::lowered(std::string_view word) const {
+  std::string text(word);
+  bool instr = false;
+  int inparens = 0;
+  int inlist = 0;
+  for (char &c : text) {
+    if (c == '"') {
+      instr = !instr;
+    } else if (!instr) {
+      inparens += (c == '(') - (c == ')');
+      inlist += (c == '[') - (c == ']');
+    }
+    if (inparens == 0 && inlist == 0 && !instr) {
+      c = tolower(c);
+    }
+  }
+  return text;
+}
+
+/**
+ * listValue
+ * @param elements the parsed elements of a list
+ * @return the list they make, expressions are kept unevaluated and words are
+ * kept as strings
+ */
+Value Parser::listValue(const std::vector<Node> &elements) const {
+  std::shared_ptr<const Cell> cells;
+  for (auto element = elements.rbegin(); element != elements.rend();
+       ++element) {
+    auto cell = std::make_shared<Cell>();
+    if (element->type == NodeType::Expression) {
+      cell->expression = std::make_shared<const Node>(*element);
+    } else if (element->type == NodeType::Word) {
+      cell->head = Value::string(element->text);
+    } else {
+      cell->head = element->value;
+    }
+    cell->tail = std::move(cells);
+    cells = std::move(cell);
+  }
+  return Value::list(std::move(cells));
+}
+
+bool Parser::isListText(std::string_view word) const {
+  return word.length() >= 2 && word[0] == '[' && word[word.length() - 1] == ']';
+}
+
+Node Parser::parseDefinition(const std::vector<std::string_view> &lines,
+                             std::vector<Token> &tokens) const {
+  std::vector<std::string> header = split(lines[0]);
+  auto function = std::make_shared<Function>();
+  if (header[0] == SUBROUTINE_DECLARATION_NAME) {
+    if (header.size() != 2) {
+      throw Exception("Cannot define subroutine \"" +
+                      (header.size() > 1 ? header[1] : "") +
+                      "\" due to parameters trying to be defined");
+    }
+    function->kind = FunctionKind::Subroutine;
+    function->name = header[1];
+  } else {
+    if (header.size() < 3 || header.size() % 2 == 0) {
+      throw Exception("Cannot define function \"" +
+                      (header.size() > 2 ? header[2] : header.back()) +
+                      "\" due to wrong number of parameters");
+    }
+    function->kind = header[0] == MEM_DECLARATION_NAME ? FunctionKind::Memoized
+                                                       : FunctionKind::Function;
+    function->returntype = header[1];
+    function->name = header[2];
+    for (uint32_t i = 3; i < header.size(); i += 2) {
+      function->parameters.push_back(
+          Parameter{header[i], header[i + 1], symbols->intern(header[i + 1])});
+    }
+  }
+  std::string &source = function->source;
+  source = std::string(lines[0]);
+  for (auto line = lines.begin() + 1; line != lines.end(); ++line) {
+    source += '\n';
+    source += *line;
+    Node statement = parseStatement(*line, tokens);
+    if (!statement.children.empty()) {
+      function->body.push_back(std::move(statement));
+    }
+  }
+  source += "\n" + FUNCTION_END_NAME;
+  Node definition;
+  definition.type = NodeType::Definition;
+  definition.text = function->source;
+  definition.function = function;
+  return definition;
+}
+
+bool Parser::startsDefinition(std::string_view line) const {
+  const std::string word = firstWord(line);
+  return word == FUNCTION_DECLARATION_NAME ||
+         word == SUBROUTINE_DECLARATION_NAME || word == MEM_DECLARATION_NAME;
+}
+
+bool Parser::endsDefinition(std::string_view line) const {
+  return firstWord(line) == FUNCTION_END_NAME;
+}
+
+std::string Parser::firstWord(std::string_view line) const {
+  size_t pos = 0;
+  std::string word;
+  return nextWord(line, pos, word) ? word : "";
+}
+
+/**
+ * listElements
+ * @param body the inside of a list without the brackets
+ * @return the top level elements, nested lists and expressions are kept whole
+ */
+std::vector<std::string_view>
+Parser::listElements(std::string_view body) const {
+  std::vector<std::string_view> elements;
+  size_t start = 0;
+  int depth = 0;
+  bool instr = false;
+  for (size_t x = 0; x < body.length(); ++x) {
+    const char c = body[x];
+    if (c == '"') {
+      instr = !instr;
+    } else if (!instr && (c == '[' || c == '(')) {
+      ++depth;
+    } else if (!instr && (c == ']' || c == ')')) {
+      --depth;
+    }
+    if (c == ' ' && depth == 0 && !instr) {
+      if (x != start) {
+        elements.push_back(body.substr(start, x - start));
+      }
+      start = x + 1;
+    }
+  }
+  if (start != body.length()) {
+    elements.push_back(body.substr(start));
+  }
+  return elements;
+}
+
+/**
+ * split function
+ * @param str string you want to split
+ * @param delim the delim char that is used to split words, default = ' '
+ * @return a vector of strings, each is one statement (can be a string,
+ * parenthesised statement, or just a value)
+ */
+std::vector<std::string> Parser::split(std::string_view str,
+                                       char delim) const {
+  std::vector<std::string> returnval;
+  size_t pos = 0;
+  std::string word;
+  while (nextWord(str, pos, word, delim)) {
+    returnval.push_back(word);
+  }
+  return returnval;
+}
+
+/**
+ * nextWord- reads the word of an expression that starts at pos
+ * @param str the expression
+ * @param pos where to start, moved past the word and the delim after it
+ * @param word the word, lowercased outside strings, parenthesis and lists
+ * @param delim the character between words
+ * @return false once there are no words left
+ */
+bool Parser::nextWord(std::string_view str, size_t &pos, std::string &word,
+                      char delim) const {
+  while (pos < str.length()) {
+    word.clear();
+    bool instr = false;
+    int inparens = 0;
+    int inlist = 0;
+    for (; pos < str.length(); ++pos) {
+      const char c = str[pos];
+      if (c == '(' && !instr) {
+        ++inparens;
+      }
+      if (c == ')' && !instr) {
+        --inparens;
+      }
+      if (c == '[' && !instr) {
+        ++inlist;
+      }
+      if (c == ']' && !instr) {
+        --inlist;
+      }
+      if (c == '"') {
+        instr = !instr;
+      }
+      if (c == delim && !word.empty() && !instr && inparens == 0 &&
+          inlist == 0) {
+        ++pos;
+        break;
+      } else if (inparens != 0 || inlist != 0 || instr) {
+        word += c;
+      } else {
+        word += tolower(c);
+      }
+    }
+    // a delim that starts a word is kept, a word of just that is dropped
+    if (!word.empty() && word != " ") {
+      return true;
+    }
+  }
+  return false;
+}
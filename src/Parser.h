@@ -0,0 +1,71 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Parser.h
+ */
+
+#ifndef MONET_PARSER_H
+#define MONET_PARSER_H
+
+#include "Exception.h"
+#include "Node.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Parser {
+public:
+  explicit Parser(Symbols &symbols);
+
+  std::vector<Node> parse(std::string_view source) const;
+  std::vector<Node> parse(const std::vector<std::string> &lines) const;
+  Node parseList(std::string_view word) const;
+  Value listValue(const std::vector<Node> &elements) const;
+  bool isListText(std::string_view word) const;
+
+  bool startsDefinition(std::string_view line) const;
+  bool endsDefinition(std::string_view line) const;
+
+  std::vector<std::string> split(std::string_view str, char delim = ' ') const;
+
+private:
+  enum class TokenKind { Word, Open, Close, OpenList, CloseList };
+
+  // a word of a line or the bracket of an expression or list, the text of an
+  // opening bracket is the text of the whole expression or list
+  struct Token {
+    TokenKind kind;
+    std::string_view text;
+  };
+
+  Node parseStatement(std::string_view line, std::vector<Token> &tokens) const;
+  Node parseDefinition(const std::vector<std::string_view> &lines,
+                       std::vector<Token> &tokens) const;
+  bool tokenize(std::string_view line, std::vector<Token> &tokens) const;
+  Node buildExpression(const std::vector<Token> &tokens, size_t &at,
+                       std::string_view text, bool keepText) const;
+  Node buildList(const std::vector<Token> &tokens, size_t &at,
+                 std::string_view text, bool keepText) const;
+  Node parseExpression(std::string_view source, bool keepText) const;
+  Node parseWord(std::string_view word, bool inList) const;
+  Node parseList(std::string_view word, bool keepText) const;
+  Node leaf(std::string word) const;
+  std::string lowered(std::string_view word) const;
+  std::string firstWord(std::string_view line) const;
+  bool nextWord(std::string_view str, size_t &pos, std::string &word,
+                char delim = ' ') const;
+  std::vector<std::string_view> listElements(std::string_view body) const;
+
+  // the symbols of the interpreter the words are parsed for
+  Symbols *symbols;
+
+  // Parsing words
+  const std::string FUNCTION_DECLARATION_NAME = "define";
+  const std::string FUNCTION_END_NAME = "end";
+  const std::string SUBROUTINE_DECLARATION_NAME = "subroutine";
+  const std::string MEM_DECLARATION_NAME = "defmem";
+};
+
+#endif // MONET_PARSER_H
@@ -0,0 +1,72 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Profiler.cpp
+ */
+
+#include "Profiler.h"
+#include <algorithm>
+
+/**
+ * enter- starts timing a call
+ * @param name the function or builtin called
+ */
+void Profiler::enter(std::string_view name) {
+  auto function = functions.find(name);
+  if (function == functions.end()) {
+    function = functions.emplace(std::string(name), Stats()).first;
+  }
+  function->second.calls++;
+  function->second.active++;
+  open.push_back(Open{&function->second, Clock::now(), {}});
+}
+
+/**
+ * leave- stops timing the call entered last
+ */
+void Profiler::leave() {
+  const Open call = open.back();
+  open.pop_back();
+  const Clock::duration spent = Clock::now() - call.start;
+  call.stats->exclusive += spent - call.children;
+  if (--call.stats->active == 0) {
+    call.stats->inclusive += spent;
+  }
+  if (!open.empty()) {
+    open.back().children += spent;
+  }
+}
+
+/**
+ * stop- leaves every call still running, used when the program quits or
+ * fails in the middle of them
+ */
+void Profiler::stop() {
+  while (!open.empty()) {
+    leave();
+  }
+}
+
+/**
+ * results
+ * @return the counters of every function called, the most exclusive time
+ * first
+ */
+std::vector<ProfileEntry> Profiler::results() const {
+  std::vector<ProfileEntry> entries;
+  for (const auto &function : functions) {
+    entries.push_back(ProfileEntry{
+        function.first, function.second.calls,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            function.second.inclusive),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            function.second.exclusive)});
+  }
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const ProfileEntry &a, const ProfileEntry &b) {
+                     return a.exclusive > b.exclusive;
+                   });
+  return entries;
+}
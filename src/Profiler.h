@@ -0,0 +1,61 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Profiler.h
+ */
+
+#ifndef MONET_PROFILER_H
+#define MONET_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ProfileEntry {
+  std::string name;
+  uint64_t calls;
+  // time from entering to leaving, counted once for recursive calls
+  std::chrono::nanoseconds inclusive;
+  // the inclusive time less that of the calls it made
+  std::chrono::nanoseconds exclusive;
+};
+
+/**
+ * Profiler- the calls and wall time of every function and builtin of a run
+ * Calls are entered and left in the order they nest, so the time of a call
+ * is split between itself and the calls it made.
+ */
+class Profiler {
+public:
+  void enter(std::string_view name);
+  void leave();
+  void stop();
+
+  std::vector<ProfileEntry> results() const;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+  struct Stats {
+    uint64_t calls = 0;
+    Clock::duration inclusive{};
+    Clock::duration exclusive{};
+    // calls of the function that have not been left yet
+    size_t active = 0;
+  };
+  struct Open {
+    Stats *stats;
+    Clock::time_point start;
+    Clock::duration children;
+  };
+
+  std::map<std::string, Stats, std::less<>> functions;
+  std::vector<Open> open;
+};
+
+#endif // MONET_PROFILER_H
@@ -0,0 +1,66 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Source.cpp
+ */
+
+#include "Source.h"
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MONET_MMAP
+#endif
+
+/**
+ * Constructor
+ * @param path the program file
+ */
+Source::Source(const std::string &path) {
+#ifdef MONET_MMAP
+  const int descriptor = open(path.c_str(), O_RDONLY);
+  if (descriptor >= 0) {
+    struct stat status;
+    if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) &&
+        status.st_size > 0) {
+      void *memory = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE,
+                          descriptor, 0);
+      if (memory != MAP_FAILED) {
+        // the parser reads it front to back once
+        madvise(memory, status.st_size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(memory);
+        size = status.st_size;
+        mapped = true;
+      }
+    }
+    close(descriptor);
+    if (mapped) {
+      return;
+    }
+  }
+#endif
+  std::ifstream file(path, std::ios::binary);
+  if (file) {
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+  }
+  data = contents.data();
+  size = contents.size();
+}
+
+Source::~Source() {
+#ifdef MONET_MMAP
+  if (mapped) {
+    munmap(const_cast<char *>(data), size);
+  }
+#endif
+}
+
+std::string_view Source::text() const { return std::string_view(data, size); }
@@ -0,0 +1,38 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Source.h
+ */
+
+#ifndef MONET_SOURCE_H
+#define MONET_SOURCE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * Source- the text of a program file
+ * Regular files are mapped into memory and parsed where they lie, anything
+ * else, such as a pipe, is read. A file that cannot be opened is empty.
+ */
+class Source {
+public:
+  explicit Source(const std::string &path);
+  ~Source();
+  Source(const Source &) = delete;
+  Source &operator=(const Source &) = delete;
+
+  std::string_view text() const;
+
+private:
+  const char *data = nullptr;
+  size_t size = 0;
+  bool mapped = false;
+  // the text when the file is not mapped
+  std::string contents;
+};
+
+#endif // MONET_SOURCE_H
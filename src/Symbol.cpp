@@ -0,0 +1,90 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Symbol.cpp
+ */
+
+#include "Symbol.h"
+#include <stdexcept>
+
+namespace {
+/**
+ * locate
+ * @param symbol a symbol
+ * @param first the size of the first block, every block is twice the last
+ * @param block set to the block that holds the name of the symbol
+ * @return where the name is in the block
+ */
+size_t locate(Symbol symbol, size_t first, size_t &block) {
+  size_t start = 0;
+  size_t size = first;
+  for (block = 0; symbol - start >= size; ++block) {
+    start += size;
+    size *= 2;
+  }
+  return symbol - start;
+}
+} // namespace
+
+Symbols::~Symbols() {
+  for (std::atomic<std::string *> &block : blocks) {
+    delete[] block.load();
+  }
+}
+
+/**
+ * intern
+ * @param name an identifier
+ * @return the symbol of the identifier, made on first use
+ */
+Symbol Symbols::intern(const std::string &name) {
+  const Symbol known = find(name);
+  if (known != NO_SYMBOL) {
+    return known;
+  }
+  std::unique_lock<std::shared_mutex> guard(lock);
+  auto found = symbols.find(name);
+  if (found != symbols.end()) {
+    return found->second;
+  }
+  const Symbol symbol = count.load(std::memory_order_relaxed);
+  size_t block;
+  const size_t index = locate(symbol, FIRST_BLOCK, block);
+  if (block >= BLOCKS) {
+    throw std::length_error("Too many names");
+  }
+  std::string *names = blocks[block].load(std::memory_order_relaxed);
+  if (names == nullptr) {
+    names = new std::string[FIRST_BLOCK << block];
+    blocks[block].store(names, std::memory_order_release);
+  }
+  names[index] = name;
+  symbols.emplace(name, symbol);
+  // publishes the name to threads reading it without the lock
+  count.store(symbol + 1, std::memory_order_release);
+  return symbol;
+}
+
+/**
+ * find- looks a name up without interning it
+ * @param name an identifier
+ * @return the symbol of the identifier, NO_SYMBOL if it has none
+ */
+Symbol Symbols::find(const std::string &name) const {
+  std::shared_lock<std::shared_mutex> guard(lock);
+  auto found = symbols.find(name);
+  return found != symbols.end() ? found->second : NO_SYMBOL;
+}
+
+const std::string &Symbols::name(Symbol symbol) const {
+  if (symbol >= count.load(std::memory_order_acquire)) {
+    throw std::out_of_range("Unknown symbol");
+  }
+  size_t block;
+  const size_t index = locate(symbol, FIRST_BLOCK, block);
+  return blocks[block].load(std::memory_order_acquire)[index];
+}
+
+size_t Symbols::size() const { return count.load(std::memory_order_acquire); }
@@ -0,0 +1,58 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Symbol.h
+ */
+
+#ifndef MONET_SYMBOL_H
+#define MONET_SYMBOL_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+typedef uint32_t Symbol;
+
+// what find returns for a name that has no symbol
+const Symbol NO_SYMBOL = UINT32_MAX;
+
+/**
+ * Symbols- interns identifiers so that they are compared as integers
+ * Every interpreter has a table of its own, shared only with the workers of
+ * its parallel builtins, so the same name always gets the same symbol
+ * within an interpreter and the names are freed along with it.
+ */
+class Symbols {
+public:
+  Symbols() = default;
+  Symbols(const Symbols &) = delete;
+  Symbols &operator=(const Symbols &) = delete;
+  ~Symbols();
+
+  Symbol intern(const std::string &name);
+  Symbol find(const std::string &name) const;
+  const std::string &name(Symbol symbol) const;
+  size_t size() const;
+
+private:
+  // block b holds FIRST_BLOCK << b names, enough blocks for every symbol
+  static constexpr size_t FIRST_BLOCK = 64;
+  static constexpr size_t BLOCKS = 26;
+
+  // shared to look names up, taken alone to add one, symbols are turned
+  // back into names without it
+  mutable std::shared_mutex lock;
+  std::unordered_map<std::string, Symbol> symbols;
+  // the names by symbol, blocks never move once made so that a name can be
+  // read while another thread interns
+  std::array<std::atomic<std::string *>, BLOCKS> blocks{};
+  std::atomic<Symbol> count{0};
+};
+
+#endif // MONET_SYMBOL_H
@@ -0,0 +1,147 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: ThreadPool.cpp
+ */
+
+#include "ThreadPool.h"
+
+namespace {
+// set on the pool's own threads, runs started there do not wait on the pool
+thread_local bool inpool = false;
+} // namespace
+
+/**
+ * Constructor
+ * @param threads how many threads to start besides the caller of run
+ */
+ThreadPool::ThreadPool(size_t threads) {
+  for (size_t x = 0; x <= threads; ++x) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for (size_t x = 1; x <= threads; ++x) {
+    this->threads.emplace_back([this, x] { loop(x); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+size_t ThreadPool::size() const { return queues.size(); }
+
+/**
+ * run- calls the task once for every index and returns when all are done
+ * @param count the number of tasks
+ * @param task called with the worker running it and the index of the task.
+ * A worker only runs one task at a time, so anything kept per worker needs
+ * no locking. The first exception a task throws is rethrown here once the
+ * others have stopped.
+ */
+void ThreadPool::run(size_t count,
+                     const std::function<void(size_t, size_t)> &task) {
+  std::unique_lock<std::mutex> exclusive(running, std::try_to_lock);
+  if (threads.empty() || inpool || !exclusive.owns_lock() || count < 2) {
+    for (size_t x = 0; x < count; ++x) {
+      task(0, x);
+    }
+    return;
+  }
+  // contiguous runs of tasks per worker, so neighbouring elements usually
+  // share a worker
+  for (size_t x = 0; x < count; ++x) {
+    queues[x * queues.size() / count]->tasks.push_back(x);
+  }
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    job = &task;
+    failure = nullptr;
+    active = threads.size();
+    ++generation;
+  }
+  wake.notify_all();
+  work(0);
+  std::unique_lock<std::mutex> guard(lock);
+  done.wait(guard, [this] { return active == 0; });
+  job = nullptr;
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
+}
+
+void ThreadPool::loop(size_t worker) {
+  inpool = true;
+  uint64_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      wake.wait(guard, [&] { return stopping || generation != seen; });
+      if (stopping) {
+        return;
+      }
+      seen = generation;
+    }
+    work(worker);
+    std::lock_guard<std::mutex> guard(lock);
+    if (--active == 0) {
+      done.notify_one();
+    }
+  }
+}
+
+void ThreadPool::work(size_t worker) {
+  size_t task;
+  while (next(worker, task)) {
+    try {
+      (*job)(worker, task);
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(lock);
+      if (!failure) {
+        failure = std::current_exception();
+      }
+      // the remaining tasks are dropped
+      for (auto &queue : queues) {
+        std::lock_guard<std::mutex> drop(queue->lock);
+        queue->tasks.clear();
+      }
+    }
+  }
+}
+
+/**
+ * next
+ * @param worker the worker asking
+ * @param task set to the task it should run
+ * @return false once every queue is empty
+ */
+bool ThreadPool::next(size_t worker, size_t &task) {
+  {
+    Queue &own = *queues[worker];
+    std::lock_guard<std::mutex> guard(own.lock);
+    if (!own.tasks.empty()) {
+      task = own.tasks.front();
+      own.tasks.pop_front();
+      return true;
+    }
+  }
+  for (size_t x = 1; x < queues.size(); ++x) {
+    Queue &victim = *queues[(worker + x) % queues.size()];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if (!victim.tasks.empty()) {
+      // taken from the far end, away from where its owner is working
+      task = victim.tasks.back();
+      victim.tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
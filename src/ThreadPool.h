@@ -0,0 +1,65 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: ThreadPool.h
+ */
+
+#ifndef MONET_THREADPOOL_H
+#define MONET_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * ThreadPool- runs the tasks of the parallel builtins
+ * Every worker has a queue of its own and steals from the others once it is
+ * empty. The thread calling run is worker 0 and works alongside the pool.
+ * Runs started while the pool is busy, or from one of its threads, run on
+ * their caller.
+ */
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t threads);
+  ~ThreadPool();
+
+  // the number of workers, counting the thread that calls run
+  size_t size() const;
+  void run(size_t count, const std::function<void(size_t, size_t)> &task);
+
+private:
+  struct Queue {
+    std::mutex lock;
+    std::deque<size_t> tasks;
+  };
+
+  void loop(size_t worker);
+  void work(size_t worker);
+  bool next(size_t worker, size_t &task);
+
+  std::vector<std::thread> threads;
+  std::vector<std::unique_ptr<Queue>> queues;
+  // held for the whole of a run, a run that finds it taken runs on its caller
+  std::mutex running;
+
+  std::mutex lock;
+  std::condition_variable wake;
+  std::condition_variable done;
+  const std::function<void(size_t, size_t)> *job = nullptr;
+  uint64_t generation = 0;
+  // pool threads still working on the current run
+  size_t active = 0;
+  bool stopping = false;
+  std::exception_ptr failure;
+};
+
+#endif // MONET_THREADPOOL_H
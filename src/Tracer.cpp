@@ -0,0 +1,161 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Tracer.cpp
+ */
+
+#include "Tracer.h"
+#include <atomic>
+#include <fstream>
+#include <iostream>
+
+namespace {
+std::atomic<uint64_t> tracers{0};
+
+// the buffer the thread last recorded into and the tracer it belongs to
+struct Cache {
+  uint64_t serial = 0;
+  void *buffer = nullptr;
+};
+thread_local Cache cache;
+
+// microseconds, the unit of the trace format, from nanoseconds
+std::string micros(uint64_t nanos) {
+  std::string text = std::to_string(nanos / 1000) + ".";
+  const std::string fraction = std::to_string(nanos % 1000);
+  return text + std::string(3 - fraction.length(), '0') + fraction;
+}
+} // namespace
+
+Tracer::Tracer()
+    : serial(++tracers), begin(std::chrono::steady_clock::now()) {}
+
+/**
+ * now
+ * @return nanoseconds since the tracer started, where spans start and end
+ */
+uint64_t Tracer::now() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+/**
+ * span- records a span of the calling thread that ends now
+ * @param name what ran, it must outlive the tracer, see keep
+ * @param category the kind of span
+ * @param start when it started, from now
+ */
+void Tracer::span(std::string_view name, const char *category,
+                  uint64_t start) {
+  Buffer &buffer = local();
+  const Span span{name, category, start, now() - start};
+  if (buffer.spans.size() < CAPACITY) {
+    buffer.spans.push_back(span);
+  } else {
+    buffer.spans[buffer.next] = span;
+    buffer.next = (buffer.next + 1) % CAPACITY;
+    buffer.dropped++;
+  }
+}
+
+/**
+ * keep
+ * @param name the name of a span that does not live in a definition, such
+ * as a file that was loaded
+ * @return a copy that lives as long as the tracer
+ */
+std::string_view Tracer::keep(const std::string &name) {
+  std::lock_guard<std::mutex> guard(lock);
+  names.push_back(name);
+  return names.back();
+}
+
+/**
+ * save- writes the spans, called once the threads have stopped recording
+ * @param path the trace file
+ * @param errors where dropped spans and a failed write are reported
+ * @return false if it could not be written
+ */
+bool Tracer::save(const std::string &path, std::ostream &errors) {
+  std::lock_guard<std::mutex> guard(lock);
+  std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (size_t tid = 0; tid < buffers.size(); ++tid) {
+    const Buffer &buffer = *buffers[tid];
+    out += first ? "\n" : ",\n";
+    first = false;
+    out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" +
+           std::to_string(tid) + ",\"args\":{\"name\":\"" +
+           (tid == 0 ? std::string("main") : "worker " + std::to_string(tid)) +
+           "\"}}";
+    if (buffer.dropped != 0) {
+      errors << "Trace kept the last " << CAPACITY << " spans of thread "
+             << tid << ", " << buffer.dropped << " were dropped" << std::endl;
+    }
+    // oldest first, a full buffer wraps around at next
+    for (size_t x = 0; x < buffer.spans.size(); ++x) {
+      const Span &span =
+          buffer.spans[(buffer.next + x) % buffer.spans.size()];
+      out += ",\n{\"name\":\"";
+      escape(span.name, out);
+      out += "\",\"cat\":\"" + std::string(span.category) +
+             "\",\"ph\":\"X\",\"ts\":" + micros(span.start) +
+             ",\"dur\":" + micros(span.duration) +
+             ",\"pid\":1,\"tid\":" + std::to_string(tid) + "}";
+    }
+  }
+  out += "\n]}\n";
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << out;
+  file.close();
+  if (!file) {
+    errors << "Unable to write trace " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * local
+ * @return the buffer of the calling thread, made on its first span
+ */
+Tracer::Buffer &Tracer::local() {
+  if (cache.serial == serial) {
+    return *static_cast<Buffer *>(cache.buffer);
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  const std::thread::id self = std::this_thread::get_id();
+  Buffer *found = nullptr;
+  for (const std::unique_ptr<Buffer> &buffer : buffers) {
+    if (buffer->thread == self) {
+      found = buffer.get();
+    }
+  }
+  if (found == nullptr) {
+    buffers.push_back(std::make_unique<Buffer>());
+    found = buffers.back().get();
+    found->thread = self;
+  }
+  cache.serial = serial;
+  cache.buffer = found;
+  return *found;
+}
+
+void Tracer::escape(std::string_view text, std::string &out) {
+  const char *hex = "0123456789abcdef";
+  for (unsigned char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (c < 0x20) {
+      out += "\\u00";
+      out += hex[c >> 4];
+      out += hex[c & 0xf];
+    } else {
+      out += c;
+    }
+  }
+}
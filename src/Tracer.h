@@ -0,0 +1,69 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Tracer.h
+ */
+
+#ifndef MONET_TRACER_H
+#define MONET_TRACER_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * Tracer- records a span for every function call of a run and writes them in
+ * the Chrome trace event format, which Perfetto and speedscope read
+ * Every thread records into a ring buffer of its own without locking, so
+ * tracing takes little of the time it measures. A thread that runs out of
+ * room keeps its most recent spans.
+ */
+class Tracer {
+public:
+  Tracer();
+
+  uint64_t now() const;
+  void span(std::string_view name, const char *category, uint64_t start);
+  std::string_view keep(const std::string &name);
+  bool save(const std::string &path, std::ostream &errors);
+
+private:
+  struct Span {
+    // a function name, which lives as long as the definitions do
+    std::string_view name;
+    const char *category;
+    uint64_t start;
+    uint64_t duration;
+  };
+  struct Buffer {
+    std::thread::id thread;
+    std::vector<Span> spans;
+    // where the next span goes once the buffer is full
+    size_t next = 0;
+    uint64_t dropped = 0;
+  };
+
+  static constexpr size_t CAPACITY = 1 << 20;
+
+  Buffer &local();
+  static void escape(std::string_view text, std::string &out);
+
+  // tells the tracers of a process apart in the cache of each thread
+  const uint64_t serial;
+  const std::chrono::steady_clock::time_point begin;
+  // taken when a thread records its first span and to keep names
+  std::mutex lock;
+  std::vector<std::unique_ptr<Buffer>> buffers;
+  std::deque<std::string> names;
+};
+
+#endif // MONET_TRACER_H
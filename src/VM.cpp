@@ -0,0 +1,291 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: VM.cpp
+ */
+
+#include "VM.h"
+#include "Interpreter.h"
+
+// Labels as values are a GNU extension, other compilers get a switch. A
+// computed goto out of a block skips the destructors of what the block
+// declared, so no handler may jump while it holds an object that owns memory.
+#if defined(__GNUC__) || defined(__clang__)
+#define MONET_COMPUTED_GOTO
+#endif
+
+VM::VM(Interpreter &interpreter) : interpreter(interpreter) {}
+
+/**
+ * run
+ * @param chunk the bytecode of a function body, its frame must already be
+ * entered
+ * @return the value the body returns
+ */
+Value VM::run(const Chunk &chunk) {
+  const size_t bottom = frames.size();
+  frames.push_back(Frame{&chunk, nullptr, stack.size(), nullptr, {}});
+  const Chunk *current = &chunk;
+  const Instruction *code = current->code.data();
+  const Instruction *ip = code;
+  try {
+
+#ifdef MONET_COMPUTED_GOTO
+    static const void *dispatch[] = {
+        &&op_Constant, &&op_Load,        &&op_CallBuiltIn, &&op_Call,
+        &&op_TailCall, &&op_Declare,     &&op_Jump,        &&op_JumpIfFalse,
+        &&op_Pop,      &&op_Eval,        &&op_Return};
+#define OP(name) op_##name:
+#define NEXT() goto *dispatch[static_cast<uint8_t>((++ip)->op)]
+#define JUMP() goto *dispatch[static_cast<uint8_t>(ip->op)]
+    JUMP();
+#else
+#define OP(name) case Op::name:
+#define NEXT()                                                                 \
+  ++ip;                                                                        \
+  continue
+#define JUMP() continue
+    while (true) {
+      switch (ip->op) {
+#endif
+// continues in the frame on top of the frame stack
+#define ENTER()                                                                \
+  current = frames.back().chunk;                                               \
+  code = current->code.data();                                                 \
+  ip = code;                                                                   \
+  JUMP()
+
+    OP(Constant) {
+      stack.push_back(current->constants[ip->a]);
+      NEXT();
+    }
+    OP(Load) {
+      stack.push_back(interpreter.lookup(ip->a, ip->b));
+      NEXT();
+    }
+    OP(CallBuiltIn) {
+      stack.push_back(interpreter.callBuiltIn(static_cast<Builtin>(ip->a),
+                                              popArguments(ip->b)));
+      NEXT();
+    }
+    OP(Call) {
+      const Function *callee = resolve(*ip, *current);
+      frames.back().ip = ip + 1;
+      if (call(callee, *ip, *current)) {
+        ENTER();
+      }
+      NEXT();
+    }
+    OP(TailCall) {
+      const Function *callee = resolve(*ip, *current);
+      if (tailcall(callee, *ip, *current)) {
+        ENTER();
+      }
+      frames.back().ip = ip + 1;
+      if (call(callee, *ip, *current)) {
+        ENTER();
+      }
+      NEXT();
+    }
+    OP(Declare) {
+      interpreter.declare(current->constants[ip->a].asString(), ip->b,
+                          stack.back());
+      stack.back() = Value();
+      NEXT();
+    }
+    OP(Jump) {
+      ip = code + ip->a;
+      JUMP();
+    }
+    OP(JumpIfFalse) {
+      if (!interpreter.isBoolean(stack.back())) {
+        throw Exception("First value must be a boolean value in if statement");
+      }
+      const bool holds = interpreter.toBoolean(stack.back());
+      stack.pop_back();
+      if (!holds) {
+        ip = code + ip->a;
+        JUMP();
+      }
+      NEXT();
+    }
+    OP(Pop) {
+      stack.pop_back();
+      NEXT();
+    }
+    OP(Eval) {
+      stack.push_back(interpreter.eval(current->nodes[ip->a]));
+      NEXT();
+    }
+    OP(Return) {
+      {
+        Value result = std::move(stack.back());
+        Frame &frame = frames.back();
+        stack.resize(frame.base);
+        if (frames.size() - 1 == bottom) {
+          frames.pop_back();
+          return result;
+        }
+        interpreter.memory.leavefn();
+        if (frame.memo != nullptr) {
+          interpreter.memory.insertmem(frame.memo->name, frame.args, result);
+        }
+        if (interpreter.profiler) {
+          interpreter.profiler->leave();
+        }
+        frames.pop_back();
+        stack.push_back(std::move(result));
+      }
+      current = frames.back().chunk;
+      code = current->code.data();
+      ip = frames.back().ip;
+      JUMP();
+    }
+
+#ifndef MONET_COMPUTED_GOTO
+      }
+    }
+#endif
+#undef OP
+#undef NEXT
+#undef JUMP
+#undef ENTER
+  } catch (...) {
+    unwind(bottom);
+    throw;
+  }
+}
+
+/**
+ * resolve- finds the function a call runs, a function defined under the name
+ * is remembered in the chunk so later calls skip the lookup
+ * @param instruction a Call or TailCall
+ * @param chunk the chunk holding the instruction
+ * @return the function the call runs, null if it is left to the interpreter
+ */
+const Function *VM::resolve(const Instruction &instruction,
+                            const Chunk &chunk) {
+  std::atomic<const Function *> &cached = chunk.callees[instruction.a];
+  const Function *callee = cached.load(std::memory_order_acquire);
+  if (callee != nullptr) {
+    return callee;
+  }
+  const std::string &name = chunk.constants[instruction.a].asString();
+  callee = interpreter.memory.findfn(name);
+  if (callee == nullptr) {
+    // not defined yet, or a parameter naming a function that can differ
+    // from call to call
+    return interpreter.callable(name);
+  }
+  cached.store(callee, std::memory_order_release);
+  return callee;
+}
+
+/**
+ * call- starts a call made by the instruction
+ * @param callee the compiled function called, null if the call is left to the
+ * interpreter
+ * @param instruction a Call or TailCall
+ * @param chunk the chunk holding the instruction
+ * @return true if a frame was pushed for the callee, false if the value of
+ * the call is already on the stack
+ */
+bool VM::call(const Function *callee, const Instruction &instruction,
+              const Chunk &chunk) {
+  const std::string &name = chunk.constants[instruction.a].asString();
+  std::vector<Value> args = popArguments(instruction.b);
+  if (callee == nullptr || !callee->bytecode) {
+    stack.push_back(interpreter.invoke(name, args));
+    return false;
+  }
+  if (args.size() != callee->parameters.size()) {
+    throw Exception("Wrong number of parameters for call to function " +
+                    name);
+  }
+  Interpreter::CallScope scope(interpreter, callee->name);
+  const Function *memo = nullptr;
+  if (callee->kind == FunctionKind::Memoized) {
+    Value check;
+    if (interpreter.memory.checkmem(callee->name, args, check)) {
+      stack.push_back(std::move(check));
+      return false;
+    }
+    memo = callee;
+  }
+  try {
+    scope.enter(*callee, args);
+  } catch (...) {
+    if (memo != nullptr) {
+      interpreter.memory.abandonmem(memo->name, args);
+    }
+    throw;
+  }
+  frames.push_back(Frame{callee->bytecode.get(), nullptr, stack.size(), memo,
+                         memo != nullptr ? std::move(args)
+                                         : std::vector<Value>()});
+  // the frame is left when it returns or unwinds
+  scope.release();
+  return true;
+}
+
+/**
+ * tailcall- runs a call in tail position in the frame of the caller
+ * @return false if the callee needs a frame of its own, that is when it is
+ * not a compiled define function, nothing has been done then
+ */
+bool VM::tailcall(const Function *callee, const Instruction &instruction,
+                  const Chunk &chunk) {
+  if (callee == nullptr || !callee->bytecode ||
+      callee->kind != FunctionKind::Function) {
+    return false;
+  }
+  if (instruction.b != callee->parameters.size()) {
+    throw Exception("Wrong number of parameters for call to function " +
+                    chunk.constants[instruction.a].asString());
+  }
+  std::vector<Value> args = popArguments(instruction.b);
+  Frame &frame = frames.back();
+  stack.resize(frame.base);
+  interpreter.memory.replacefn(args, *callee);
+  if (interpreter.profiler) {
+    interpreter.profiler->leave();
+    interpreter.profiler->enter(callee->name);
+  }
+  frame.chunk = callee->bytecode.get();
+  return true;
+}
+
+/**
+ * unwind- drops the frames of a run that ended with an exception
+ * @param bottom the index of the first frame of the run, its function frame
+ * and profile entry belong to whoever started the run
+ */
+void VM::unwind(size_t bottom) {
+  while (frames.size() > bottom + 1) {
+    interpreter.memory.leavefn();
+    if (interpreter.profiler) {
+      interpreter.profiler->leave();
+    }
+    if (frames.back().memo != nullptr) {
+      interpreter.memory.abandonmem(frames.back().memo->name,
+                                    frames.back().args);
+    }
+    frames.pop_back();
+  }
+  stack.resize(frames.back().base);
+  frames.pop_back();
+}
+
+/**
+ * popArguments
+ * @param count how many values to take off the stack
+ * @return the values in the order they were pushed
+ */
+std::vector<Value> VM::popArguments(uint32_t count) {
+  std::vector<Value> args(std::make_move_iterator(stack.end() - count),
+                          std::make_move_iterator(stack.end()));
+  stack.resize(stack.size() - count);
+  return args;
+}
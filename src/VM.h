@@ -0,0 +1,56 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: VM.h
+ */
+
+#ifndef MONET_VM_H
+#define MONET_VM_H
+
+#include "Bytecode.h"
+#include "Value.h"
+#include <string>
+#include <vector>
+
+class Interpreter;
+
+/**
+ * VM- a stack machine that runs compiled function bodies
+ * Calls from one compiled function to another do not recurse on the native
+ * stack, the frames of the callers wait on a stack of their own. Calls in
+ * tail position replace the frame of the caller.
+ */
+class VM {
+public:
+  explicit VM(Interpreter &interpreter);
+  Value run(const Chunk &chunk);
+
+private:
+  struct Frame {
+    const Chunk *chunk;
+    // where the frame continues once the call it made returns
+    const Instruction *ip;
+    // index of the first value of the frame on the value stack
+    size_t base;
+    // the defmem function whose result the frame computes, null otherwise
+    const Function *memo;
+    std::vector<Value> args;
+  };
+
+  const Function *resolve(const Instruction &instruction, const Chunk &chunk);
+  bool call(const Function *callee, const Instruction &instruction,
+            const Chunk &chunk);
+  bool tailcall(const Function *callee, const Instruction &instruction,
+                const Chunk &chunk);
+  void unwind(size_t bottom);
+  std::vector<Value> popArguments(uint32_t count);
+
+  Interpreter &interpreter;
+  // shared by nested runs, each run only touches values above its base
+  std::vector<Value> stack;
+  std::vector<Frame> frames;
+};
+
+#endif // MONET_VM_H
@@ -0,0 +1,312 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Value.cpp
+ */
+
+#include "Value.h"
+#include "Exception.h"
+#include "Node.h"
+#include <functional>
+
+namespace {
+/**
+ * compareCells- orders lists element by element, unevaluated elements by
+ * their text
+ * @return 0 if equal, 1 if a is greater, -1 if b is greater
+ */
+int compareCells(const Cell *a, const Cell *b) {
+  for (; a != b && a != nullptr && b != nullptr;
+       a = a->tail.get(), b = b->tail.get()) {
+    if (a->expression || b->expression) {
+      if (!a->expression || !b->expression) {
+        return a->expression ? 1 : -1;
+      }
+      int order = a->expression->text.compare(b->expression->text);
+      if (order != 0) {
+        return order > 0 ? 1 : -1;
+      }
+    } else if (a->head < b->head) {
+      return -1;
+    } else if (b->head < a->head) {
+      return 1;
+    }
+  }
+  if (a == b) {
+    return 0;
+  }
+  return a != nullptr ? 1 : -1;
+}
+} // namespace
+
+/**
+ * ~Cell- releases the cells this one owns alone in a loop, so dropping a
+ * long list does not recurse once per element
+ */
+Cell::~Cell() {
+  std::shared_ptr<const Cell> next = std::move(tail);
+  while (next && next.use_count() == 1) {
+    next = std::move(const_cast<Cell &>(*next).tail);
+  }
+}
+
+Value::Value() : kind(Type::None) {}
+
+Value Value::boolean(bool value) {
+  Value v;
+  v.kind = Type::Boolean;
+  v.payload = value;
+  return v;
+}
+
+Value Value::number(const num &value) {
+  Value v;
+  v.kind = Type::Number;
+  v.payload = value;
+  return v;
+}
+
+Value Value::string(const std::string &value) {
+  Value v;
+  v.kind = Type::String;
+  v.payload = std::make_shared<const std::string>(value);
+  return v;
+}
+
+Value Value::list(std::shared_ptr<const Cell> cells) {
+  Value v;
+  v.kind = Type::List;
+  v.payload = std::move(cells);
+  return v;
+}
+
+/**
+ * listOf
+ * @param elements the elements in order
+ * @return a new list holding the elements
+ */
+Value Value::listOf(const std::vector<Value> &elements) {
+  std::shared_ptr<const Cell> cells;
+  for (auto element = elements.rbegin(); element != elements.rend();
+       ++element) {
+    auto cell = std::make_shared<Cell>();
+    cell->head = *element;
+    cell->tail = std::move(cells);
+    cells = std::move(cell);
+  }
+  return list(std::move(cells));
+}
+
+Value Value::function(const std::string &name) {
+  Value v = string(name);
+  v.kind = Type::Function;
+  return v;
+}
+
+Value::Type Value::type() const { return kind; }
+
+bool Value::isNone() const { return kind == Type::None; }
+
+bool Value::isBoolean() const { return kind == Type::Boolean; }
+
+bool Value::isNumber() const { return kind == Type::Number; }
+
+bool Value::isString() const { return kind == Type::String; }
+
+bool Value::isList() const { return kind == Type::List; }
+
+bool Value::isFunction() const { return kind == Type::Function; }
+
+bool Value::asBoolean() const {
+  if (kind != Type::Boolean) {
+    throw Exception("Expected a boolean but got \"" + str() + "\"");
+  }
+  return std::get<bool>(payload);
+}
+
+const num &Value::asNumber() const {
+  if (kind != Type::Number) {
+    throw Exception("Expected a num but got \"" + str() + "\"");
+  }
+  return std::get<num>(payload);
+}
+
+const std::string &Value::asString() const {
+  if (kind != Type::String && kind != Type::Function) {
+    throw Exception("Expected text but got \"" + str() + "\"");
+  }
+  return *std::get<std::shared_ptr<const std::string>>(payload);
+}
+
+const std::shared_ptr<const Cell> &Value::asList() const {
+  if (kind != Type::List) {
+    throw Exception("Expected a list but got \"" + str() + "\"");
+  }
+  return std::get<std::shared_ptr<const Cell>>(payload);
+}
+
+/**
+ * str
+ * @return the value as it is printed
+ */
+std::string Value::str() const {
+  switch (kind) {
+  case Type::None:
+    return "";
+  case Type::Boolean:
+    return std::get<bool>(payload) ? "true" : "false";
+  case Type::Number:
+    return std::get<num>(payload).str();
+  case Type::List: {
+    std::string text = "[";
+    for (const Cell *cell = asList().get(); cell != nullptr;
+         cell = cell->tail.get()) {
+      if (cell != asList().get()) {
+        text += " ";
+      }
+      text += cell->expression ? "(" + cell->expression->text + ")"
+                               : cell->head.str();
+    }
+    return text + "]";
+  }
+  case Type::String:
+  case Type::Function:
+    return asString();
+  }
+  return "";
+}
+
+std::string Value::typeName() const {
+  switch (kind) {
+  case Type::None:
+    return "none";
+  case Type::Boolean:
+    return "boolean";
+  case Type::Number:
+    return "num";
+  case Type::String:
+    return "string";
+  case Type::List:
+    return "list";
+  case Type::Function:
+    return "fn";
+  }
+  return "";
+}
+
+/**
+ * hash
+ * @return a hash that is the same for equal values
+ */
+size_t Value::hash() const {
+  size_t seed = static_cast<size_t>(kind);
+  auto combine = [&seed](size_t h) {
+    seed ^= h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+  };
+  switch (kind) {
+  case Type::None:
+    break;
+  case Type::Boolean:
+    combine(asBoolean());
+    break;
+  case Type::Number:
+    combine(asNumber().hash());
+    break;
+  case Type::List:
+    for (const Cell *cell = asList().get(); cell != nullptr;
+         cell = cell->tail.get()) {
+      combine(cell->expression
+                  ? std::hash<std::string>()(cell->expression->text)
+                  : cell->head.hash());
+    }
+    break;
+  case Type::String:
+  case Type::Function:
+    combine(std::hash<std::string>()(asString()));
+    break;
+  }
+  return seed;
+}
+
+bool Value::operator==(const Value &other) const {
+  if (kind != other.kind) {
+    return false;
+  }
+  switch (kind) {
+  case Type::None:
+    return true;
+  case Type::Boolean:
+    return asBoolean() == other.asBoolean();
+  case Type::Number:
+    return asNumber() == other.asNumber();
+  case Type::List:
+    return compareCells(asList().get(), other.asList().get()) == 0;
+  default:
+    return asString() == other.asString();
+  }
+}
+
+bool Value::operator!=(const Value &other) const { return !(*this == other); }
+
+/**
+ * operator<- orders values by type first, then by value
+ */
+bool Value::operator<(const Value &other) const {
+  if (kind != other.kind) {
+    return kind < other.kind;
+  }
+  switch (kind) {
+  case Type::None:
+    return false;
+  case Type::Boolean:
+    return asBoolean() < other.asBoolean();
+  case Type::Number:
+    return asNumber() < other.asNumber();
+  case Type::List:
+    return compareCells(asList().get(), other.asList().get()) < 0;
+  default:
+    return asString() < other.asString();
+  }
+}
+
+/**
+ * isNumeric
+ * @param text a word from the source or user input
+ * @return true if the text is a number literal
+ */
+bool Value::isNumeric(const std::string &text) {
+  if (text.length() == 0) {
+    return false;
+  }
+  // optional sign, then digits with at most one decimal point
+  uint32_t x = (text[0] == '-') ? 1 : 0;
+  bool digits = false;
+  bool point = false;
+  for (; x < text.length(); x++) {
+    if (isdigit(text[x])) {
+      digits = true;
+    } else if (text[x] == '.' && !point) {
+      point = true;
+    } else if ((text[x] == 'e' || text[x] == 'E') && digits) {
+      // exponent as printed for very large or small values
+      ++x;
+      if (x < text.length() && (text[x] == '-' || text[x] == '+')) {
+        ++x;
+      }
+      if (x == text.length()) {
+        return false;
+      }
+      for (; x < text.length(); x++) {
+        if (!isdigit(text[x])) {
+          return false;
+        }
+      }
+      return true;
+    } else {
+      return false;
+    }
+  }
+  return digits;
+}
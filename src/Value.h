@@ -0,0 +1,85 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: Value.h
+ */
+
+#ifndef MONET_VALUE_H
+#define MONET_VALUE_H
+
+#include "Number.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+struct Cell;
+struct Node;
+
+/**
+ * Value- a runtime value of any Monet type
+ * Strings and function names share one immutable buffer between copies and
+ * lists share their cells, so passing values around never copies them.
+ */
+class Value {
+public:
+  enum class Type : uint8_t { None, Boolean, Number, String, List, Function };
+
+  Value();
+  static Value boolean(bool value);
+  static Value number(const num &value);
+  static Value string(const std::string &value);
+  static Value list(std::shared_ptr<const Cell> cells = nullptr);
+  static Value listOf(const std::vector<Value> &elements);
+  static Value function(const std::string &name);
+
+  Type type() const;
+  bool isNone() const;
+  bool isBoolean() const;
+  bool isNumber() const;
+  bool isString() const;
+  bool isList() const;
+  bool isFunction() const;
+
+  bool asBoolean() const;
+  const num &asNumber() const;
+  // the text of a string or function value
+  const std::string &asString() const;
+  // the first cell of a list, null for the empty list
+  const std::shared_ptr<const Cell> &asList() const;
+
+  std::string str() const;
+  std::string typeName() const;
+  size_t hash() const;
+
+  bool operator==(const Value &other) const;
+  bool operator!=(const Value &other) const;
+  bool operator<(const Value &other) const;
+
+  static bool isNumeric(const std::string &text);
+
+private:
+  Type kind;
+  std::variant<std::monostate, bool, num, std::shared_ptr<const std::string>,
+               std::shared_ptr<const Cell>>
+      payload;
+};
+
+/**
+ * Cell- one link of an immutable list
+ * Consing onto a list shares all of its cells, so head, tail and cons never
+ * copy elements.
+ */
+struct Cell {
+  Value head;
+  // a parenthesised element, it is evaluated each time it is read
+  std::shared_ptr<const Node> expression;
+  std::shared_ptr<const Cell> tail;
+
+  ~Cell();
+};
+
+#endif // MONET_VALUE_H
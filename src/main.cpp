@@ -7,34 +7,124 @@
  */
 
 #include "Interpreter.h"
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 
 // Welcome to Monet (A Basic Inspired Programming Language)
 
+// printed output waits here until a flush point, unless --unbuffered
+static char outputBuffer[1 << 16];
+
+static bool isCount(const std::string &text) {
+  return !text.empty() && text.length() < 20 &&
+         std::all_of(text.begin(), text.end(), ::isdigit);
+}
+
 /**
- * Main function
+ * Main function- runs the file given, or the REPL without one, under the
+ * command line options described in the README
  * @param argc number of cmd args
  * @param argv cmd args
  * @return 0 on success, else on failure
  */
 int main(int argc, char *argv[]) {
-  std::cout << "Welcome to the Monet Interpreter" << std::endl;
-  if (argc > 2) {
-    std::cerr << "Need a file to interpret or no command line parameter to "
-                 "enter the REPL"
+  Options options;
+  std::string filename;
+  // the function --each calls, empty without --each
+  std::string function;
+  bool each = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--engine=vm") {
+      options.engine = Engine::VM;
+    } else if (arg == "--engine=tree") {
+      options.engine = Engine::Tree;
+    } else if (arg.rfind("--memo-budget=", 0) == 0 &&
+               isCount(arg.substr(14))) {
+      options.memoBudget = std::stoull(arg.substr(14));
+    } else if (arg.rfind("--memo-function-budget=", 0) == 0 &&
+               isCount(arg.substr(23))) {
+      options.memoFunctionBudget = std::stoull(arg.substr(23));
+    } else if (arg.rfind("--max-depth=", 0) == 0 && isCount(arg.substr(12))) {
+      options.maxDepth = std::stoull(arg.substr(12));
+    } else if (arg.rfind("--threads=", 0) == 0 && isCount(arg.substr(10))) {
+      options.threads = std::stoull(arg.substr(10));
+    } else if (arg == "--memo-stats") {
+      options.memoStats = true;
+    } else if (arg.rfind("--trace=", 0) == 0 && arg.length() > 8) {
+      options.trace = arg.substr(8);
+    } else if (arg == "--profile") {
+      options.profile = true;
+    } else if (arg == "--unbuffered") {
+      options.unbuffered = true;
+    } else if (arg == "--memo-wait") {
+      options.memoWait = true;
+    } else if (arg.rfind("--memo-cache=", 0) == 0 && arg.length() > 13) {
+      options.memoCache = arg.substr(13);
+    } else if (arg.rfind("--module-cache=", 0) == 0 && arg.length() > 15) {
+      options.moduleCache = arg.substr(15);
+    } else if (arg == "--each") {
+      each = true;
+    } else if (each && filename != "" && function == "" &&
+               arg.substr(0, 2) != "--") {
+      function = arg;
+    } else if (arg.substr(0, 2) == "--" || filename != "") {
+      std::cerr << "Usage: Monet [--engine=vm|tree] [--memo-budget=bytes] "
+                   "[--memo-function-budget=bytes] [--memo-stats] "
+                   "[--memo-cache=path] [--memo-wait] [--max-depth=calls] "
+                   "[--threads=count] [--unbuffered] [--profile] "
+                   "[--trace=path] [--module-cache=directory] "
+                   "[file | --each file function]"
+                << std::endl;
+      exit(1);
+    } else {
+      filename = arg;
+    }
+  }
+  if (!options.unbuffered) {
+    // before anything is written, stdout cannot change buffers after
+    setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+  }
+  if (each && function == "") {
+    std::cerr << "--each needs a file and the function to call on every line"
               << std::endl;
     exit(1);
   }
+  if (!each) {
+    // the output of --each is only the results
+    std::cout << "Welcome to the Monet Interpreter" << std::endl;
+  }
+  int status = EXIT_SUCCESS;
   try {
-    if (argc == 1) {
-      Interpreter i;
-    } else if (argc == 2) {
-      Interpreter i(argv[1]);
+    Interpreter interpreter(options);
+    bool failed = false;
+    std::string error;
+    try {
+      if (filename == "") {
+        interpreter.repl();
+      } else {
+        interpreter.runFile(filename);
+      }
+      if (each) {
+        interpreter.each(function);
+      }
+    } catch (Quit &quit) {
+      status = quit.status();
+    } catch (Exception &e) {
+      failed = true;
+      error = e.what();
+      status = EXIT_FAILURE;
+    }
+    // what was printed goes out before the error
+    interpreter.finish();
+    if (failed) {
+      std::cerr << error << std::endl;
     }
   } catch (Exception &e) {
     std::cerr << e.what() << std::endl;
     return EXIT_FAILURE;
   }
 
-  return EXIT_SUCCESS;
-}
\ No newline at end of file
+  return status;
+}
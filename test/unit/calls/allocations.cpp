@@ -0,0 +1,108 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: allocations.cpp
+ */
+
+// Checks that calling a function does not copy its body. The same calls are
+// made to a function with a one line body and to one whose body holds a large
+// expression that is never evaluated. Copying the body would make every call
+// of the second function allocate more, so the allocations that more calls
+// add must stay within one per call of each other.
+
+#include "../../../src/Interpreter.h"
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+
+namespace {
+std::atomic<size_t> allocations{0};
+
+const int CALLS = 500;
+}
+
+void *operator new(std::size_t size) {
+  allocations++;
+  void *memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+/**
+ * script
+ * @param unused an expression the function carries but never evaluates
+ * @param calls how many times the function is called
+ * @return the program text
+ */
+std::string script(const std::string &unused, int calls) {
+  return "define num f num x\n"
+         "return (if (eq x 0) " +
+         unused +
+         " x)\n"
+         "end\n"
+         "define num loop num n\n"
+         "return (if (eq n 0) 0 (loop (sub n (f 1))))\n"
+         "end\n"
+         "num r (loop " +
+         std::to_string(calls) + ")\n";
+}
+
+size_t run(const std::string &program, Engine engine) {
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "monet_allocations.mo")
+          .string();
+  std::ofstream(path) << program;
+  Options options;
+  options.engine = engine;
+  size_t before = allocations;
+  {
+    Interpreter interpreter(options);
+    interpreter.runFile(path);
+  }
+  size_t used = allocations - before;
+  std::filesystem::remove(path);
+  return used;
+}
+
+/**
+ * percall
+ * @return the allocations made by CALLS more calls of the function
+ */
+size_t percall(const std::string &unused, Engine engine) {
+  return run(script(unused, 2 * CALLS), engine) -
+         run(script(unused, CALLS), engine);
+}
+} // namespace
+
+int main() {
+  std::string large = "0";
+  for (int x = 0; x < 40; ++x) {
+    large = "(add " + std::to_string(x) + " " + large + ")";
+  }
+  bool passed = true;
+  for (Engine engine : {Engine::Tree, Engine::VM}) {
+    const char *name = engine == Engine::Tree ? "tree" : "vm";
+    size_t small = percall("0", engine);
+    size_t big = percall(large, engine);
+    std::cout << name << ": " << small << " and " << big << " allocations for "
+              << CALLS << " calls" << std::endl;
+    if (big >= small + CALLS) {
+      std::cout << name << ": calls copy the function body" << std::endl;
+      passed = false;
+    }
+  }
+  return passed ? 0 : 1;
+}
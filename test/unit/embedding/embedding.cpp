@@ -0,0 +1,472 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: embedding.cpp
+ */
+
+// Runs Monet through the library the way a host program would: functions are
+// defined from source and called with C++ values, quitting and errors are
+// caught, and the same interpreter keeps working after both. C++ functions
+// are registered and called from Monet, with arguments of every kind, lines
+// are streamed through functions, loaded files are kept parsed between
+// interpreters, and every interpreter has its own symbol table.
+
+#include "../../../src/Interpreter.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+bool passed = true;
+
+void check(bool condition, const std::string &what) {
+  if (!condition) {
+    std::cout << what << std::endl;
+    passed = false;
+  }
+}
+
+/**
+ * quits
+ * @param interpreter runs the source
+ * @param source code that should quit
+ * @return the status it quit with, -1 if it did not quit
+ */
+int quits(Interpreter &interpreter, const std::string &source) {
+  try {
+    interpreter.runSource(source);
+  } catch (Quit &quit) {
+    return quit.status();
+  }
+  return -1;
+}
+
+void run(Engine engine) {
+  const std::string name = engine == Engine::Tree ? "tree: " : "vm: ";
+  Options options;
+  options.engine = engine;
+  Interpreter interpreter(options);
+  interpreter.runSource("define num square num x\n"
+                        "return (mul x x)\n"
+                        "end\n"
+                        "define string pick boolean first string a string b\n"
+                        "return (if first a b)\n"
+                        "end\n"
+                        "num base 10\n");
+
+  Value result = interpreter.callFunction("square", {Value::number(12)});
+  check(result.isNumber() && result.asNumber() == num(144),
+        name + "square 12 gave " + result.str());
+  result = interpreter.callFunction(
+      "pick", {Value::boolean(false), Value::string("a"), Value::string("b")});
+  check(result.isString() && result.asString() == "b",
+        name + "pick gave " + result.str());
+  result = interpreter.callFunction("add", {Value::number(1), Value::number(2)});
+  check(result.str() == "3", name + "add 1 2 gave " + result.str());
+  result = interpreter.runSource("add base (square 3)");
+  check(result.str() == "19", name + "variables were not kept, gave " +
+                                  result.str());
+
+  check(quits(interpreter, "quit 3") == 3, name + "quit 3 was not caught");
+  check(quits(interpreter, "define num stop num x\n"
+                           "return (if (eq x 0) (quit 7) (stop (sub x 1)))\n"
+                           "end\n"
+                           "stop 50\n") == 7,
+        name + "quit inside calls was not caught");
+  result = interpreter.callFunction("square", {Value::number(5)});
+  check(result.str() == "25", name + "unusable after quit, gave " +
+                                  result.str());
+
+  try {
+    interpreter.callFunction("missing", {});
+    check(false, name + "calling a missing function did not throw");
+  } catch (Exception &) {
+  }
+  try {
+    interpreter.runSource("define num bad num x\n"
+                          "return (if (eq x 0) (undefined) (bad (sub x 1)))\n"
+                          "end\n"
+                          "bad 20\n");
+    check(false, name + "an error inside calls did not throw");
+  } catch (Exception &) {
+  }
+  try {
+    // the tail call cannot convert its argument, the caller keeps its frame
+    interpreter.runSource("define num number num x\n"
+                          "return x\n"
+                          "end\n"
+                          "define num pass string s\n"
+                          "return (number s)\n"
+                          "end\n"
+                          "pass \"abc\"\n");
+    check(false, name + "a tail call with a bad argument did not throw");
+  } catch (Exception &) {
+  }
+  result = interpreter.callFunction("square", {Value::number(6)});
+  check(result.str() == "36", name + "unusable after an error, gave " +
+                                  result.str());
+
+  interpreter.defineNative(
+      "vec.sum", {"list"}, [](const std::vector<Value> &args) {
+        num sum(0);
+        for (const Cell *cell = args[0].asList().get(); cell != nullptr;
+             cell = cell->tail.get()) {
+          sum += cell->head.asNumber();
+        }
+        return Value::number(sum);
+      });
+  interpreter.defineNative(
+      "vec.scale", {"num", "num"}, [](const std::vector<Value> &args) {
+        return Value::number(args[0].asNumber() * args[1].asNumber());
+      });
+  interpreter.defineNative(
+      "host.twice", {"fn", "num"}, [&](const std::vector<Value> &args) {
+        Value once = interpreter.callFunction(args[0].asString(), {args[1]});
+        return interpreter.callFunction(args[0].asString(), {once});
+      });
+  result = interpreter.runSource("vec.sum [1 2 (add 1 2)]");
+  check(result.str() == "6", name + "vec.sum gave " + result.str());
+  result = interpreter.runSource("define num total list xs\n"
+                                 "return (vec.sum (map square xs))\n"
+                                 "end\n"
+                                 "total [1 2 3]\n");
+  check(result.str() == "14", name + "total gave " + result.str());
+  result = interpreter.runSource("map vec.sum [[1 2] [3 4]]");
+  check(result.str() == "[3 7]", name + "map vec.sum gave " + result.str());
+  result = interpreter.runSource("host.twice square 3");
+  check(result.str() == "81", name + "host.twice gave " + result.str());
+  result = interpreter.callFunction("vec.scale", {Value::string("4"),
+                                                  Value::number(5)});
+  check(result.str() == "20", name + "vec.scale gave " + result.str());
+
+  const auto rejects = [&](const std::string &what, auto &&attempt) {
+    try {
+      attempt();
+      check(false, name + what + " did not throw");
+    } catch (Exception &) {
+    }
+  };
+  const Native nothing = [](const std::vector<Value> &) { return Value(); };
+  rejects("a name without a library",
+          [&] { interpreter.defineNative("sum", {"list"}, nothing); });
+  rejects("an unknown type",
+          [&] { interpreter.defineNative("vec.bad", {"int"}, nothing); });
+  rejects("redefining",
+          [&] { interpreter.defineNative("vec.sum", {"list"}, nothing); });
+  rejects("a wrong number of parameters",
+          [&] { interpreter.runSource("vec.scale 1"); });
+}
+/**
+ * callbacks- a native function that catches the error of a call back into
+ * the interpreter goes on in the frame of the function that called it
+ * @param engine the engine the functions run on
+ */
+void callbacks(Engine engine) {
+  const std::string name = engine == Engine::Tree ? "tree: " : "vm: ";
+  std::ostringstream errors;
+  Options options;
+  options.engine = engine;
+  options.profile = true;
+  options.errors = &errors;
+  Interpreter interpreter(options);
+  interpreter.defineNative(
+      "host.catch", {"fn", "string"}, [&](const std::vector<Value> &args) {
+        try {
+          return interpreter.callFunction(args[0].asString(), {args[1]});
+        } catch (Exception &) {
+          return Value::number(-1);
+        }
+      });
+  interpreter.runSource(
+      "define num deep num x\n"
+      "return (if (eq x 0) (undefined) (add 1 (deep (sub x 1))))\n"
+      "end\n"
+      "defmem num memodeep num x\n"
+      "return (if (eq x 0) (undefined) (add 1 (memodeep (sub x 1))))\n"
+      "end\n"
+      "define num number num x\n"
+      "return x\n"
+      "end\n"
+      "define num pass string s\n"
+      "return (number s)\n"
+      "end\n"
+      "define num keeps fn f string arg num y\n"
+      "num caught (host.catch f arg)\n"
+      "return (add y caught)\n"
+      "end\n");
+  for (const std::string &callee : {"deep", "memodeep", "pass"}) {
+    const std::string arg = callee == "pass" ? "abc" : "5";
+    const Value result = interpreter.callFunction(
+        "keeps",
+        {Value::string(callee), Value::string(arg), Value::number(3)});
+    check(result.str() == "2", name + "after a caught error in " + callee +
+                                   " the caller gave " + result.str());
+  }
+}
+
+/**
+ * FlushCounter- a string stream buffer that counts how often it is flushed
+ */
+class FlushCounter : public std::stringbuf {
+public:
+  int flushes = 0;
+
+protected:
+  int sync() override {
+    ++flushes;
+    return std::stringbuf::sync();
+  }
+};
+
+/**
+ * workers- the parallel builtins keep their workers between calls, which
+ * neither flush the output nor miss functions defined after they were made
+ * @param engine the engine the functions run on
+ */
+void workers(Engine engine) {
+  const std::string name = engine == Engine::Tree ? "tree: " : "vm: ";
+  FlushCounter buffer;
+  std::ostream output(&buffer);
+  Options options;
+  options.engine = engine;
+  options.threads = 4;
+  options.output = &output;
+  Interpreter interpreter(options);
+  Value result = interpreter.runSource("define num square num x\n"
+                                       "return (mul x x)\n"
+                                       "end\n"
+                                       "pmap square [1 2 3 4 5 6 7 8]\n"
+                                       "pmap square [1 2 3 4 5 6 7 8]\n"
+                                       "define num cube num x\n"
+                                       "return (mul x (mul x x))\n"
+                                       "end\n"
+                                       "pmap cube [1 2 3 4 5 6 7 8]\n");
+  check(result.str() == "[1 8 27 64 125 216 343 512]",
+        name + "pmap of a function defined later gave " + result.str());
+  check(buffer.flushes == 0, name + "pmap flushed the output " +
+                                 std::to_string(buffer.flushes) + " times");
+}
+
+/**
+ * FailingFlush- a string stream buffer that cannot be flushed
+ */
+class FailingFlush : public std::stringbuf {
+protected:
+  int sync() override { return -1; }
+};
+
+/**
+ * finishing- finish throws what writing out the output throws, an
+ * interpreter destroyed without it drops the error
+ */
+void finishing() {
+  FailingFlush first, second;
+  std::ostream finished(&first), dropped(&second);
+  finished.exceptions(std::ios::badbit);
+  dropped.exceptions(std::ios::badbit);
+  Options options;
+  options.output = &finished;
+  {
+    Interpreter interpreter(options);
+    interpreter.runSource("println 1");
+    try {
+      interpreter.finish();
+      check(false, "finish did not throw when the output failed");
+    } catch (std::ios_base::failure &) {
+    }
+    // finished already, so the destructor does not try again
+  }
+  options.output = &dropped;
+  {
+    Interpreter interpreter(options);
+    interpreter.runSource("println 2");
+  }
+  check(first.str() == "1\n" && second.str() == "2\n",
+        "the output was " + first.str() + second.str());
+}
+
+/**
+ * each- streams lines through functions the way Monet --each does
+ * @param engine the engine the functions run on
+ */
+void each(Engine engine) {
+  const std::string name = engine == Engine::Tree ? "tree: " : "vm: ";
+  std::istringstream input;
+  std::ostringstream output;
+  Options options;
+  options.engine = engine;
+  options.input = &input;
+  options.output = &output;
+  Interpreter interpreter(options);
+  interpreter.runSource("define num triple num x\n"
+                        "return (mul x 3)\n"
+                        "end\n"
+                        "define boolean big num x\n"
+                        "return (gt x 5)\n"
+                        "end\n"
+                        "define string noisy string line\n"
+                        "print \"> \"\n"
+                        "return line\n"
+                        "end\n");
+  const auto stream = [&](const std::string &function,
+                          const std::string &lines) {
+    input.clear();
+    input.str(lines);
+    output.str("");
+    const size_t count = interpreter.each(function);
+    return std::to_string(count) + ":" + output.str();
+  };
+  std::string result = stream("triple", "1\n2\r\n7");
+  check(result == "3:3\n6\n21\n", name + "triple gave " + result);
+  result = stream("big", "1\n9\n3\n12\n");
+  check(result == "4:9\n12\n", name + "big gave " + result);
+  result = stream("noisy", "a\nb\n");
+  check(result == "2:> a\n> b\n", name + "noisy gave " + result);
+  std::string many;
+  for (int x = 0; x < 50000; ++x) {
+    many += std::to_string(x) + "\n";
+  }
+  result = stream("triple", many);
+  check(result.rfind("50000:0\n3\n", 0) == 0 &&
+            result.size() > many.size() &&
+            result.compare(result.size() - 7, 7, "149997\n") == 0,
+        name + "triple of many lines was cut");
+}
+
+/**
+ * modules- loads a file through a module cache, from a fresh cache, a kept
+ * one, a damaged one and one made for other text, and loads a file again
+ * once it no longer fails
+ * @param engine the engine the loaded functions run on
+ */
+void modules(Engine engine) {
+  const std::string name = engine == Engine::Tree ? "tree: " : "vm: ";
+  const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "monet_modules_test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory / "lib");
+  const std::string library = (directory / "lib" / "triple.mo").string();
+  std::ofstream(library) << "define num triple num x\n"
+                            "return (mul x 3)\n"
+                            "end\n"
+                            "println \"triple loaded\"\n";
+  const auto load = [&](const std::string &cache) {
+    std::ostringstream output;
+    Options options;
+    options.engine = engine;
+    options.output = &output;
+    options.moduleCache = cache;
+    Interpreter interpreter(options);
+    // the second load names the same file by another path
+    interpreter.runSource(
+        "load \"" + library + "\"\n" + "load \"" +
+        (directory / "lib" / "." / "triple.mo").string() + "\"\n");
+    const Value result =
+        interpreter.callFunction("triple", {Value::number(4)});
+    interpreter.runSource("flush");
+    return output.str() + result.str();
+  };
+  const std::string cache = (directory / "cache").string();
+  const std::string expected = "triple loaded\n12";
+  std::string result = load("");
+  check(result == expected, name + "loading twice gave " + result);
+  result = load(cache);
+  check(result == expected, name + "loading into the cache gave " + result);
+  std::vector<std::filesystem::path> entries;
+  for (const auto &entry : std::filesystem::directory_iterator(cache)) {
+    entries.push_back(entry.path());
+  }
+  check(entries.size() == 1, name + "the cache has " +
+                                 std::to_string(entries.size()) + " entries");
+  result = load(cache);
+  check(result == expected, name + "loading from the cache gave " + result);
+  for (const std::filesystem::path &entry : entries) {
+    // cut off after the header, mid node
+    std::filesystem::resize_file(entry,
+                                 std::filesystem::file_size(entry) / 2);
+  }
+  result = load(cache);
+  check(result == expected,
+        name + "loading past a damaged entry gave " + result);
+
+  // an entry made for other text of the same length, as if the hashes of
+  // the two texts collided, is not used
+  std::ofstream(library) << "define num triple num x\n"
+                            "return (mul x 5)\n"
+                            "end\n"
+                            "println \"triple loaded\"\n";
+  load(cache);
+  for (const auto &entry : std::filesystem::directory_iterator(cache)) {
+    if (entry.path() != entries[0]) {
+      std::filesystem::copy_file(
+          entries[0], entry.path(),
+          std::filesystem::copy_options::overwrite_existing);
+    }
+  }
+  result = load(cache);
+  check(result == "triple loaded\n20",
+        name + "loading past an entry for other text gave " + result);
+
+  // a file that fails is loaded again once it is fixed
+  const std::string broken = (directory / "lib" / "broken.mo").string();
+  std::ofstream(broken) << "undefined 1\n"
+                           "define num half num x\n"
+                           "return (div x 2)\n"
+                           "end\n";
+  Options options;
+  options.engine = engine;
+  Interpreter interpreter(options);
+  try {
+    interpreter.runSource("load \"" + broken + "\"\n");
+    check(false, name + "loading a broken file did not throw");
+  } catch (Exception &) {
+  }
+  std::ofstream(broken) << "define num half num x\n"
+                           "return (div x 2)\n"
+                           "end\n";
+  interpreter.runSource("load \"" + broken + "\"\n");
+  result = interpreter.callFunction("half", {Value::number(8)}).str();
+  check(result == "4", name + "a fixed file was not loaded again, gave " +
+                           result);
+  std::filesystem::remove_all(directory);
+}
+
+/**
+ * symbols- every interpreter interns names in a table of its own, that keeps
+ * its names readable as it grows and is not added to by looking names up
+ */
+void symbols() {
+  Symbols first, second;
+  first.intern("first");
+  check(first.intern("x") == 1 && second.intern("x") == 0,
+        "symbol tables are shared");
+  bool kept = true;
+  for (int x = 0; x < 100000; ++x) {
+    const std::string name = "name" + std::to_string(x);
+    kept = kept && first.name(first.intern(name)) == name;
+  }
+  kept = kept && first.name(1) == "x" && first.intern("name5") == 7;
+  check(kept && first.size() == 100002 && second.size() == 1,
+        "symbols were lost as the table grew");
+  check(first.find("name5") == 7 && second.find("name5") == NO_SYMBOL &&
+            second.size() == 1,
+        "finding a name interned it");
+}
+} // namespace
+
+int main() {
+  for (Engine engine : {Engine::Tree, Engine::VM}) {
+    run(engine);
+    callbacks(engine);
+    workers(engine);
+    each(engine);
+    modules(engine);
+  }
+  symbols();
+  finishing();
+  return passed ? 0 : 1;
+}
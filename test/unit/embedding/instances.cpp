@@ -0,0 +1,137 @@
+/**
+ * Stephen Hunter Barbella
+ * GitHub: hman523
+ * Email: shbarbella@gmail.com
+ * Licence: MIT
+ * File: instances.cpp
+ */
+
+// Runs many interpreters at once, several on every core, each with its own
+// input, output and memo table. Every instance defines the same names with
+// different values, reads a line and quits with a status of its own, so any
+// state shared between instances shows up as wrong output or a wrong status.
+// The same instances are then run one after another to report the speedup.
+
+#include "../../../src/Interpreter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+const int ROUNDS = 40;
+
+std::atomic<int> failures{0};
+
+std::string script(int id) {
+  return "num id " + std::to_string(id) +
+         "\n"
+         "defmem num fib num x\n"
+         "return (if (le x 1) x (add (fib (sub x 1)) (fib (sub x 2))))\n"
+         "end\n"
+         "define num slow num x\n"
+         "return (if (le x 1) x (add (slow (sub x 1)) (slow (sub x 2))))\n"
+         "end\n"
+         "define list build num n list acc\n"
+         "return (if (eq n 0) acc (build (sub n 1) (cons n acc)))\n"
+         "end\n"
+         "read who\n"
+         "println who \" \" id\n"
+         "println (fib (add 50 (mul id 3)))\n"
+         "println (slow 16)\n"
+         "println (reduce add 0 (map fib (build id [])))\n"
+         "quit id\n";
+}
+
+num fib(int x) {
+  num a(0), b(1);
+  for (int i = 0; i < x; ++i) {
+    num next = a + b;
+    a = b;
+    b = next;
+  }
+  return a;
+}
+
+std::string expected(int id) {
+  num sum(0);
+  for (int x = 1; x <= id; ++x) {
+    sum = sum + fib(x);
+  }
+  return "instance" + std::to_string(id) + " " + std::to_string(id) + "\n" +
+         fib(50 + 3 * id).str() + "\n987\n" + sum.str() + "\n";
+}
+
+/**
+ * instance- runs the script of one instance and checks what it did
+ * @param id the number of the instance, it quits with it
+ * @param engine the engine of the instance
+ */
+void instance(int id, Engine engine) {
+  std::istringstream input("instance" + std::to_string(id) + "\n");
+  std::ostringstream output, errors;
+  Options options;
+  options.engine = engine;
+  options.threads = 1;
+  options.input = &input;
+  options.output = &output;
+  options.errors = &errors;
+  int status = -1;
+  {
+    Interpreter interpreter(options);
+    try {
+      interpreter.runSource(script(id));
+    } catch (Quit &quit) {
+      status = quit.status();
+    } catch (Exception &e) {
+      errors << e.what();
+    }
+  }
+  if (status != id || output.str() != expected(id) || errors.str() != "") {
+    if (failures++ < 5) {
+      std::cout << "instance " << id << " quit with " << status
+                << ", printed\n"
+                << output.str() << "and reported\n"
+                << errors.str() << std::endl;
+    }
+  }
+}
+
+/**
+ * runall
+ * @param threads how many threads share the instances
+ * @return the milliseconds all instances took
+ */
+double runall(int threads) {
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> running;
+  for (int t = 0; t < threads; ++t) {
+    running.emplace_back([t, threads] {
+      for (int x = t; x < ROUNDS * threads; x += threads) {
+        instance(1 + x % 97, x % 2 == 0 ? Engine::VM : Engine::Tree);
+      }
+    });
+  }
+  for (std::thread &thread : running) {
+    thread.join();
+  }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+} // namespace
+
+int main() {
+  const int cores = std::max(2u, std::thread::hardware_concurrency());
+  // more threads than cores, so that instances are also switched mid-run
+  const double parallel = runall(2 * cores);
+  const double serial = runall(1) * 2 * cores;
+  std::cout << 2 * cores * ROUNDS << " instances on " << 2 * cores
+            << " threads: " << parallel << " ms, about " << serial
+            << " ms one after another" << std::endl;
+  return failures == 0 ? 0 : 1;
+}